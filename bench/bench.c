@@ -0,0 +1,1052 @@
+#define _POSIX_C_SOURCE 200809L
+#include "morse.h"
+#include "morse-cache.h"
+#include "morse-parallel.h"
+#include "morse-scan.h"
+#include "morse-tables.h"
+#include "morse-timing.h"
+#include "spsc-queue.h"
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+
+static const char* MORSE_CODE_SEQUENCE[] = {
+    ".-", "-...", "-.-.", "-..", ".", "..-.", "--.", "....", "..",
+    ".---", "-.-", ".-..", "--", "-.", "---", ".--.", "--.-", ".-.",
+    "...", "-", "..-", "...-", ".--", "-..-", "-.--", "--..", "-----",
+    ".----", "..---", "...--", "....-", ".....", "-....", "--...", "---..", "----."
+};
+
+static const char ALPHABET[] = {
+    'A','B','C','D','E','F','G','H','I','J','K','L','M',
+    'N','O','P','Q','R','S','T','U','V','W','X','Y','Z',
+    '0','1','2','3','4','5','6','7','8','9'
+};
+
+static const size_t ALPHABET_SIZE = sizeof(ALPHABET) / sizeof(ALPHABET[0]);
+
+#define CORPUS_LETTERS (4u * 1024u * 1024u)
+#define BENCH_ROUNDS 5
+#define BENCH_ROUND_SECONDS 0.02 // each round repeats the operation for at least this long
+#define BENCH_MAX_RESULTS 256
+#define NODE_BENCH_ELEMENTS 4096
+#define PIPELINE_ELEMENTS (1u << 20) // Nodes handed from a producer thread to a consumer thread
+#define PIPELINE_CAPACITY 1024
+#define PIPELINE_BATCH 64
+
+static bool valid_PipelineNode(Node node)
+{
+    (void)node;
+    return true;
+}
+
+DEFINE_SPSC_QUEUE(Node, size_t, PIPELINE_CAPACITY)
+GENERATE_SPSC_QUEUE(Node, size_t, PIPELINE_CAPACITY, valid_PipelineNode)
+
+static const size_t CORPUS_SIZES[] = { 4u * 1024u, 256u * 1024u, 4u * 1024u * 1024u };
+
+
+// Allocation counting: `make bench` links with -Wl,--wrap=malloc,... so every allocation
+// made by the library ends up here. Parallel code allocates on worker threads, hence atomic.
+#ifdef BENCH_COUNT_ALLOCATIONS
+static atomic_size_t bench_allocations;
+
+void* __real_malloc(size_t size);
+void* __real_calloc(size_t count, size_t size);
+void* __real_realloc(void* ptr, size_t size);
+
+void* __wrap_malloc(size_t size)
+{
+    atomic_fetch_add_explicit(&bench_allocations, 1, memory_order_relaxed);
+    return __real_malloc(size);
+}
+
+void* __wrap_calloc(size_t count, size_t size)
+{
+    atomic_fetch_add_explicit(&bench_allocations, 1, memory_order_relaxed);
+    return __real_calloc(count, size);
+}
+
+void* __wrap_realloc(void* ptr, size_t size)
+{
+    atomic_fetch_add_explicit(&bench_allocations, 1, memory_order_relaxed);
+    return __real_realloc(ptr, size);
+}
+
+static size_t allocation_count(void)
+{
+    return atomic_load_explicit(&bench_allocations, memory_order_relaxed);
+}
+
+static const bool ALLOCATIONS_COUNTED = true;
+#else
+static size_t allocation_count(void)
+{
+    return 0;
+}
+
+static const bool ALLOCATIONS_COUNTED = false;
+#endif
+
+typedef struct BenchResult
+{
+    char name[48];
+    char corpus[24];
+    size_t bytes; // input bytes per operation
+    size_t chars; // characters (or elements) per operation, the ns/char divisor
+    double seconds; // best time of one operation
+    double allocations; // per operation, negative when not counted
+} BenchResult;
+
+static BenchResult results[BENCH_MAX_RESULTS];
+static size_t result_count = 0;
+
+
+static double now_seconds(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+// xorshift64, fixed seed so every run sees the same corpus
+static uint64_t bench_random(uint64_t* state)
+{
+    *state ^= *state << 13;
+    *state ^= *state >> 7;
+    *state ^= *state << 17;
+    return *state;
+}
+
+// Random words of 1-8 letters, letters separated by ' ', words by " / "
+static char* generate_morse_corpus(size_t letters, size_t* out_len)
+{
+    char* corpus = malloc(letters * 8 + 1);
+    if (!corpus) return NULL;
+
+    uint64_t state = 0x9E3779B97F4A7C15ull;
+    size_t len = 0;
+    size_t word_left = 0;
+    for (size_t i = 0; i < letters; i++) {
+        if (word_left == 0) {
+            if (i > 0) { MEMORY_COPY(corpus + len, " / ", 3); len += 3; }
+            word_left = 1 + bench_random(&state) % 8;
+        } else {
+            corpus[len++] = ' ';
+        }
+        const char* code = MORSE_CODE_SEQUENCE[bench_random(&state) % ALPHABET_SIZE];
+        size_t code_len = strlen(code);
+        MEMORY_COPY(corpus + len, code, code_len);
+        len += code_len;
+        word_left--;
+    }
+    corpus[len] = '\0';
+    *out_len = len;
+    return corpus;
+}
+
+// English-ish text: random words of 1-8 letters and digits separated by single spaces
+static char* generate_text_corpus(size_t letters, size_t* out_len)
+{
+    static const char CHARACTERS[] = "ETAOINSHRDLCUMWFGYPBVKJXQZ0123456789";
+    char* corpus = malloc(letters * 2 + 1);
+    if (!corpus) return NULL;
+
+    uint64_t state = 0xD1B54A32D192ED03ull;
+    size_t len = 0;
+    size_t word_left = 0;
+    for (size_t i = 0; i < letters; i++) {
+        if (word_left == 0) {
+            if (i > 0) corpus[len++] = ' ';
+            word_left = 1 + bench_random(&state) % 8;
+        }
+        corpus[len++] = CHARACTERS[bench_random(&state) % (sizeof(CHARACTERS) - 1)];
+        word_left--;
+    }
+    corpus[len] = '\0';
+    *out_len = len;
+    return corpus;
+}
+
+typedef enum CorpusKind
+{
+    CORPUS_RANDOM,      // uniform letters, digits and spaces
+    CORPUS_ENGLISH,     // common English words with Zipf frequencies, some digits and punctuation
+    CORPUS_LONG_WORDS,  // words of 256-1279 letters, almost no word gaps
+    CORPUS_LONG_TOKENS  // Morse tokens of 8-63 symbols, none of them a letter
+} CorpusKind;
+
+static const char* const CORPUS_NAMES[] = { "random", "english", "long-words", "long-tokens" };
+
+// The 100 most frequent English words by rank, sampled with weight 1/rank
+static const char* const ENGLISH_WORDS[] = {
+    "the", "of", "and", "to", "a", "in", "is", "you", "that", "it", "he", "was", "for", "on", "are",
+    "as", "with", "his", "they", "i", "at", "be", "this", "have", "from", "or", "one", "had", "by",
+    "word", "but", "not", "what", "all", "were", "we", "when", "your", "can", "said", "there", "use",
+    "an", "each", "which", "she", "do", "how", "their", "if", "will", "up", "other", "about", "out",
+    "many", "then", "them", "these", "so", "some", "her", "would", "make", "like", "him", "into",
+    "time", "has", "look", "two", "more", "write", "go", "see", "number", "no", "way", "could",
+    "people", "my", "than", "first", "water", "been", "call", "who", "oil", "its", "now", "find",
+    "long", "down", "day", "did", "get", "come", "made", "may", "part"
+};
+
+static const size_t ENGLISH_WORD_COUNT = sizeof(ENGLISH_WORDS) / sizeof(ENGLISH_WORDS[0]);
+
+// Exactly `size` bytes of the given kind, the last word may be cut short
+static char* generate_sized_corpus(CorpusKind kind, size_t size)
+{
+    static const char LETTERS[] = "ETAOINSHRDLCUMWFGYPBVKJXQZ0123456789";
+    static const char RANDOM_CHARACTERS[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789 ";
+    char* corpus = malloc(size + 2048); // room for the longest piece past `size`
+    if (!corpus) return NULL;
+
+    double zipf_total = 0;
+    for (size_t rank = 0; rank < ENGLISH_WORD_COUNT; rank++) zipf_total += 1.0 / (double)(rank + 1);
+
+    uint64_t state = 0x2545F4914F6CDD1Dull + (uint64_t)kind;
+    size_t len = 0;
+    while (len < size) {
+        switch (kind) {
+            case CORPUS_RANDOM:
+                corpus[len++] = RANDOM_CHARACTERS[bench_random(&state) % (sizeof(RANDOM_CHARACTERS) - 1)];
+                break;
+            case CORPUS_ENGLISH:
+                if (len > 0) corpus[len++] = ' ';
+                if (bench_random(&state) % 32 == 0) {
+                    size_t digits = 1 + bench_random(&state) % 4;
+                    for (size_t i = 0; i < digits; i++) corpus[len++] = (char)('0' + bench_random(&state) % 10);
+                } else {
+                    double pick = (double)(bench_random(&state) >> 11) * 0x1p-53 * zipf_total;
+                    size_t rank = 0;
+                    while (rank + 1 < ENGLISH_WORD_COUNT && (pick -= 1.0 / (double)(rank + 1)) > 0) rank++;
+                    size_t word_len = strlen(ENGLISH_WORDS[rank]);
+                    MEMORY_COPY(corpus + len, ENGLISH_WORDS[rank], word_len);
+                    len += word_len;
+                }
+                if (bench_random(&state) % 10 == 0) corpus[len++] = bench_random(&state) % 2 ? ',' : '.';
+                break;
+            case CORPUS_LONG_WORDS: {
+                if (len > 0) corpus[len++] = ' ';
+                size_t word_len = 256 + bench_random(&state) % 1024;
+                for (size_t i = 0; i < word_len; i++) {
+                    corpus[len++] = LETTERS[bench_random(&state) % (sizeof(LETTERS) - 1)];
+                }
+                break;
+            }
+            case CORPUS_LONG_TOKENS: {
+                if (len > 0) corpus[len++] = ' ';
+                if (len > 0 && bench_random(&state) % 6 == 0) { MEMORY_COPY(corpus + len, "/ ", 2); len += 2; }
+                size_t token_len = 8 + bench_random(&state) % 56;
+                for (size_t i = 0; i < token_len; i++) corpus[len++] = bench_random(&state) & 1 ? '-' : '.';
+                break;
+            }
+        }
+    }
+    corpus[size] = '\0';
+    return corpus;
+}
+
+// Amateur radio traffic: CQ calls and QSO exchanges between 64 callsigns, about `size` bytes
+static char* generate_traffic_corpus(size_t size)
+{
+    static const char* const EXCHANGE[] = {
+        "CQ CQ CQ DE %s %s K", "%s DE %s GM OM TNX FER CALL", "UR RST 599 599 BK", "QTH BOSTON BOSTON",
+        "NAME JOHN JOHN HW CPY", "RIG IC7300 ES ANT DIPOLE", "WX SUNNY TEMP 20C", "QSL VIA BURO", "73 ES GL SK",
+        "%s DE %s R R FB", "QRZ DE %s", "PSE QRS QRM", "TU 73 %s DE %s EE"
+    };
+    char calls[64][8];
+    uint64_t state = 0x9E3779B97F4A7C15ull;
+    for (size_t i = 0; i < 64; i++) {
+        snprintf(calls[i], sizeof(calls[i]), "%c%c%u%c%c%c", "KWN"[bench_random(&state) % 3],
+                 (char)('A' + bench_random(&state) % 26), (unsigned)(bench_random(&state) % 10),
+                 (char)('A' + bench_random(&state) % 26), (char)('A' + bench_random(&state) % 26),
+                 (char)('A' + bench_random(&state) % 26));
+    }
+
+    char* corpus = malloc(size + 256);
+    if (!corpus) return NULL;
+    size_t len = 0;
+    while (len < size) {
+        const char* a = calls[bench_random(&state) % 64];
+        const char* b = calls[bench_random(&state) % 64];
+        if (len > 0) corpus[len++] = ' ';
+        len += (size_t)snprintf(corpus + len, 256, EXCHANGE[bench_random(&state) % 13], a, b);
+    }
+    corpus[size] = '\0';
+    return corpus;
+}
+
+// The decode loop as it was before decode_letter_n: one malloc'd token per letter
+static size_t decode_copying_tokens(const BTreeNode* root, const char* message, char* output)
+{
+    size_t len = 0;
+    const char* ptr = message;
+    while (*ptr) {
+        while (*ptr == ' ' || *ptr == '/') {
+            if (*ptr == '/') output[len++] = ' ';
+            ptr++;
+        }
+        if (!*ptr) break;
+        const char* end = ptr;
+        while (*end && *end != ' ' && *end != '/') end++;
+
+        size_t token_len = (size_t)(end - ptr);
+        char* token = malloc(token_len + 1);
+        if (!token) return len;
+        MEMORY_COPY(token, ptr, token_len);
+        token[token_len] = '\0';
+        char decoded = decode_letter(root, token);
+        free(token);
+
+        output[len++] = decoded ? decoded : '?';
+        ptr = end;
+    }
+    return len;
+}
+
+
+// Every timed operation goes through a callback so rounds, calibration and counting live in one place
+typedef void (*BenchFn)(void* context);
+
+static void record(const char* name, const char* corpus, size_t bytes, size_t chars, double seconds, double allocations)
+{
+    if (result_count < BENCH_MAX_RESULTS) {
+        BenchResult* result = &results[result_count++];
+        snprintf(result->name, sizeof(result->name), "%s", name);
+        snprintf(result->corpus, sizeof(result->corpus), "%s", corpus);
+        result->bytes = bytes;
+        result->chars = chars;
+        result->seconds = seconds;
+        result->allocations = allocations;
+    }
+    printf("%-32s %-16s %10.2f MB/s %9.2f ns/char",
+           name, corpus, (double)bytes / seconds / 1e6, seconds * 1e9 / (double)chars);
+    if (allocations >= 0) printf(" %12.2f allocs/op", allocations);
+    printf("\n");
+}
+
+// Best of BENCH_ROUNDS, each round repeats `fn` until it has run for about BENCH_ROUND_SECONDS
+static void bench_run(const char* name, const char* corpus, size_t bytes, size_t chars, BenchFn fn, void* context)
+{
+    double start = now_seconds();
+    fn(context); // warm-up, also sizes the rounds
+    double once = now_seconds() - start;
+    size_t iterations = once < BENCH_ROUND_SECONDS ? (size_t)(BENCH_ROUND_SECONDS / (once + 1e-9)) + 1 : 1;
+
+    size_t allocations = allocation_count();
+    double best = 1e30;
+    for (int round = 0; round < BENCH_ROUNDS; round++) {
+        start = now_seconds();
+        for (size_t i = 0; i < iterations; i++) fn(context);
+        double elapsed = (now_seconds() - start) / (double)iterations;
+        if (elapsed < best) best = elapsed;
+    }
+    double per_operation = ALLOCATIONS_COUNTED
+        ? (double)(allocation_count() - allocations) / (double)(BENCH_ROUNDS * iterations)
+        : -1.0;
+    record(name, corpus, bytes, chars, best, per_operation);
+}
+
+typedef struct CodecContext
+{
+    const BTreeNode* root;
+    const MorseDecodeTable* decode_table;
+    const char* input;
+    size_t length;
+    char* output; // at least length + 1 bytes when the callback writes into it
+    size_t threads;
+    size_t checksum;
+} CodecContext;
+
+static void run_morse_encode(void* context)
+{
+    CodecContext* codec = context;
+    free(morse_encode(codec->root, codec->input));
+}
+
+static void run_morse_decode(void* context)
+{
+    CodecContext* codec = context;
+    free(morse_decode(codec->root, codec->input));
+}
+
+static void run_decode_reference(void* context)
+{
+    CodecContext* codec = context;
+    free(morse_decode_reference(codec->root, codec->input));
+}
+
+static void run_decode_copying_tokens(void* context)
+{
+    CodecContext* codec = context;
+    codec->checksum += decode_copying_tokens(codec->root, codec->input, codec->output);
+}
+
+// Same decode into one caller buffer, no allocation per call
+static void run_decode_into(void* context)
+{
+    CodecContext* codec = context;
+    codec->checksum += morse_decode_into_with_table(codec->decode_table, codec->input, codec->length,
+                                                    codec->output, codec->length + 1);
+}
+
+static void run_decode_parallel(void* context)
+{
+    CodecContext* codec = context;
+    free(morse_decode_parallel(codec->root, codec->input, codec->length, codec->threads, MORSE_DECODE_SKIP, NULL));
+}
+
+static void run_encode_parallel(void* context)
+{
+    CodecContext* codec = context;
+    free(morse_encode_parallel(codec->root, codec->input, codec->length, codec->threads));
+}
+
+static void run_encode_letter(void* context)
+{
+    CodecContext* codec = context;
+    for (size_t i = 0; i < ALPHABET_SIZE; i++) {
+        char* code = encode_letter(codec->root, ALPHABET[i]);
+        codec->checksum += code ? strlen(code) : 0;
+        free(code);
+    }
+}
+
+static void run_decode_letter(void* context)
+{
+    CodecContext* codec = context;
+    for (size_t i = 0; i < ALPHABET_SIZE; i++) {
+        codec->checksum += (size_t)decode_letter(codec->root, MORSE_CODE_SEQUENCE[i]);
+    }
+}
+
+// Push NODE_BENCH_ELEMENTS onto a fresh container and take them all off again
+static void run_node_stack(void* context)
+{
+    CodecContext* codec = context;
+    Node_stack_s stack;
+    Node_stack_init(&stack);
+    for (size_t i = 0; i < NODE_BENCH_ELEMENTS; i++) Node_stack_push(&stack, (Node){ codec->root, NULL });
+    while (!Node_stack_empty(&stack)) {
+        codec->checksum += Node_stack_peek(&stack).node != NULL;
+        Node_stack_pop(&stack);
+    }
+    Node_stack_delete(&stack);
+}
+
+static void run_node_queue(void* context)
+{
+    CodecContext* codec = context;
+    Node_queue_s queue;
+    Node_queue_init(&queue);
+    for (size_t i = 0; i < NODE_BENCH_ELEMENTS; i++) Node_queue_enque(&queue, (Node){ codec->root, NULL });
+    while (!Node_queue_empty(&queue)) {
+        codec->checksum += Node_queue_peek(&queue).node != NULL;
+        Node_queue_deque(&queue);
+    }
+    Node_queue_delete(&queue);
+}
+
+// The same traffic in blocks of PIPELINE_BATCH, with the capacity reserved up front
+static void run_node_stack_n(void* context)
+{
+    CodecContext* codec = context;
+    Node block[PIPELINE_BATCH];
+    for (size_t i = 0; i < PIPELINE_BATCH; i++) block[i] = (Node){ codec->root, NULL };
+    Node_stack_s stack;
+    Node_stack_init(&stack);
+    Node_stack_reserve(&stack, NODE_BENCH_ELEMENTS);
+    for (size_t i = 0; i < NODE_BENCH_ELEMENTS; i += PIPELINE_BATCH) Node_stack_push_n(&stack, block, PIPELINE_BATCH);
+    size_t taken;
+    while ((taken = Node_stack_pop_n(&stack, block, PIPELINE_BATCH)) > 0) {
+        codec->checksum += taken + (block[0].node != NULL);
+    }
+    Node_stack_delete(&stack);
+}
+
+static void run_node_queue_n(void* context)
+{
+    CodecContext* codec = context;
+    Node block[PIPELINE_BATCH];
+    for (size_t i = 0; i < PIPELINE_BATCH; i++) block[i] = (Node){ codec->root, NULL };
+    Node_queue_s queue;
+    Node_queue_init(&queue);
+    Node_queue_reserve(&queue, NODE_BENCH_ELEMENTS);
+    for (size_t i = 0; i < NODE_BENCH_ELEMENTS; i += PIPELINE_BATCH) Node_queue_enque_n(&queue, block, PIPELINE_BATCH);
+    size_t taken;
+    while ((taken = Node_queue_deque_n(&queue, block, PIPELINE_BATCH)) > 0) {
+        codec->checksum += taken + (block[0].node != NULL);
+    }
+    Node_queue_delete(&queue);
+}
+
+typedef struct ClassifyContext
+{
+    MorseClassifyFn classify;
+    const char* input;
+    size_t length;
+    uint64_t checksum;
+} ClassifyContext;
+
+static void run_classify(void* context)
+{
+    ClassifyContext* scan = context;
+    for (size_t offset = 0; offset + MORSE_SCAN_BLOCK <= scan->length; offset += MORSE_SCAN_BLOCK) {
+        MorseBlockMasks masks;
+        scan->classify(scan->input + offset, &masks);
+        scan->checksum += masks.dot ^ masks.dash ^ masks.space ^ masks.slash;
+    }
+}
+
+typedef struct TimingContext
+{
+    const double* events; // key-down durations, key-up ones negated
+    size_t count;
+    uint64_t checksum;
+} TimingContext;
+
+static void run_timing_feed(void* context)
+{
+    TimingContext* timing = context;
+    MorseTimingDecoder decoder;
+    morse_timing_init(&decoder, &MORSE_DECODE_TABLE_DEFAULT);
+    char output[MORSE_TIMING_EVENT_BOUND];
+    for (size_t i = 0; i < timing->count; i++) {
+        double event = timing->events[i];
+        timing->checksum += morse_timing_feed(&decoder, event > 0, event > 0 ? event : -event, output);
+    }
+    timing->checksum += morse_timing_finish(&decoder, output);
+}
+
+// Key events for Morse text at one unit per dot, lightly jittered as if keyed by hand. From the
+// first word gap past the middle, after a pause of 20 units, the sender keys `slowdown` times slower.
+static double* generate_timing_events(const char* morse, double slowdown, size_t* count)
+{
+    size_t length = strlen(morse);
+    double* events = malloc((2 * length + 1) * sizeof(double));
+    if (!events) { return NULL; }
+    uint64_t state = 0x5EED;
+    size_t n = 0;
+    double gap = 0;
+    double unit = 1;
+    for (const char* c = morse; *c; c++) {
+        double jitter = 0.9 + (double)(bench_random(&state) % 21) / 100.0;
+        if (*c == ' ') { if (gap < 3 * unit) gap = 3 * unit; continue; }
+        if (*c == '/') {
+            gap = 7 * unit;
+            if (unit == 1 && (size_t)(c - morse) >= length / 2) {
+                gap = 20;
+                unit = slowdown;
+            }
+            continue;
+        }
+        if (n > 0) events[n++] = -(gap > 0 ? gap : unit) * jitter;
+        events[n++] = (*c == '-' ? 3 : 1) * unit * jitter;
+        gap = 0;
+    }
+    *count = n;
+    return events;
+}
+
+// Words of `expected` that the timing decoder reproduces, aligned from the end so a garbled
+// stretch does not shift the words after it
+static size_t timing_words_decoded(const double* events, size_t count, const char* expected, size_t* words)
+{
+    *words = 0;
+    char* decoded = malloc(count + MORSE_TIMING_EVENT_BOUND);
+    if (!decoded) { return 0; }
+    MorseTimingDecoder decoder;
+    morse_timing_init(&decoder, &MORSE_DECODE_TABLE_DEFAULT);
+    size_t len = 0;
+    for (size_t i = 0; i < count; i++) {
+        len += morse_timing_feed(&decoder, events[i] > 0, events[i] > 0 ? events[i] : -events[i], decoded + len);
+    }
+    len += morse_timing_finish(&decoder, decoded + len);
+
+    size_t matched = 0;
+    size_t a = strlen(expected), b = len;
+    while (a > 0) {
+        while (a > 0 && expected[a - 1] == ' ') a--;
+        while (b > 0 && decoded[b - 1] == ' ') b--;
+        if (a == 0) break;
+        size_t a_end = a, b_end = b;
+        while (a > 0 && expected[a - 1] != ' ') a--;
+        while (b > 0 && decoded[b - 1] != ' ') b--;
+        (*words)++;
+        if (a_end - a == b_end - b && memcmp(expected + a, decoded + b, a_end - a) == 0) matched++;
+    }
+    free(decoded);
+    return matched;
+}
+
+// Producer and consumer spin with sched_yield() so the bench also runs on one core
+typedef struct PipelineContext
+{
+    const BTreeNode* root;
+    size_t batch; // 1: single enque/deque, else enque_n/deque_n of this many
+    spsc_queue(Node) spsc;
+    Node_queue_s locked; // the mutex-guarded baseline, bounded to PIPELINE_CAPACITY
+    pthread_mutex_t lock;
+    size_t checksum;
+} PipelineContext;
+
+static void* spsc_producer(void* context)
+{
+    PipelineContext* pipeline = context;
+    Node batch[PIPELINE_BATCH];
+    for (size_t i = 0; i < PIPELINE_BATCH; i++) batch[i] = (Node){ pipeline->root, NULL };
+    for (size_t sent = 0; sent < PIPELINE_ELEMENTS;) {
+        size_t moved = pipeline->batch == 1
+            ? Node_spsc_queue_enque(&pipeline->spsc, batch[0])
+            : Node_spsc_queue_enque_n(&pipeline->spsc, batch, pipeline->batch);
+        if (moved == 0) sched_yield();
+        sent += moved;
+    }
+    return NULL;
+}
+
+static void run_spsc_pipeline(void* context)
+{
+    PipelineContext* pipeline = context;
+    Node_spsc_queue_init(&pipeline->spsc);
+    pthread_t producer;
+    if (pthread_create(&producer, NULL, spsc_producer, pipeline) != 0) { return; }
+    Node batch[PIPELINE_BATCH];
+    for (size_t received = 0; received < PIPELINE_ELEMENTS;) {
+        size_t moved = pipeline->batch == 1
+            ? Node_spsc_queue_deque(&pipeline->spsc, batch)
+            : Node_spsc_queue_deque_n(&pipeline->spsc, batch, pipeline->batch);
+        if (moved == 0) sched_yield();
+        for (size_t i = 0; i < moved; i++) pipeline->checksum += batch[i].node != NULL;
+        received += moved;
+    }
+    pthread_join(producer, NULL);
+}
+
+static void* locked_producer(void* context)
+{
+    PipelineContext* pipeline = context;
+    for (size_t sent = 0; sent < PIPELINE_ELEMENTS;) {
+        pthread_mutex_lock(&pipeline->lock);
+        bool room = pipeline->locked.len < PIPELINE_CAPACITY;
+        if (room) Node_queue_enque(&pipeline->locked, (Node){ pipeline->root, NULL });
+        pthread_mutex_unlock(&pipeline->lock);
+        if (room) sent++;
+        else sched_yield();
+    }
+    return NULL;
+}
+
+static void run_locked_pipeline(void* context)
+{
+    PipelineContext* pipeline = context;
+    pthread_t producer;
+    if (pthread_create(&producer, NULL, locked_producer, pipeline) != 0) { return; }
+    for (size_t received = 0; received < PIPELINE_ELEMENTS;) {
+        pthread_mutex_lock(&pipeline->lock);
+        bool taken = !Node_queue_empty(&pipeline->locked);
+        if (taken) {
+            pipeline->checksum += Node_queue_peek(&pipeline->locked).node != NULL;
+            Node_queue_deque(&pipeline->locked);
+        }
+        pthread_mutex_unlock(&pipeline->lock);
+        if (taken) received++;
+        else sched_yield();
+    }
+    pthread_join(producer, NULL);
+}
+
+static void corpus_label(char* label, size_t capacity, CorpusKind kind, size_t size)
+{
+    if (size >= 1024u * 1024u) snprintf(label, capacity, "%s-%zuM", CORPUS_NAMES[kind], size / (1024u * 1024u));
+    else snprintf(label, capacity, "%s-%zuK", CORPUS_NAMES[kind], size / 1024u);
+}
+
+// morse_encode and morse_decode over every corpus kind and size; decode input is the encoded text
+static void bench_corpora(const BTreeNode* root)
+{
+    for (size_t kind = CORPUS_RANDOM; kind <= CORPUS_LONG_TOKENS; kind++) {
+        for (size_t s = 0; s < sizeof(CORPUS_SIZES) / sizeof(CORPUS_SIZES[0]); s++) {
+            char label[24];
+            corpus_label(label, sizeof(label), (CorpusKind)kind, CORPUS_SIZES[s]);
+            char* text = generate_sized_corpus((CorpusKind)kind, CORPUS_SIZES[s]);
+            if (!text) {
+                fprintf(stderr, "Memory allocation failed\n");
+                return;
+            }
+
+            CodecContext codec = { root, NULL, text, CORPUS_SIZES[s], NULL, 1, 0 };
+            char* morse = text;
+            if (kind != CORPUS_LONG_TOKENS) {
+                bench_run("morse_encode", label, codec.length, codec.length, run_morse_encode, &codec);
+                morse = morse_encode(root, text);
+                if (!morse) {
+                    fprintf(stderr, "morse_encode failed\n");
+                    free(text);
+                    return;
+                }
+            }
+            codec.input = morse;
+            codec.length = strlen(morse);
+            bench_run("morse_decode", label, codec.length, codec.length, run_morse_decode, &codec);
+
+            if (morse != text) free(morse);
+            free(text);
+        }
+    }
+}
+
+static void bench_letters(const BTreeNode* root)
+{
+    CodecContext codec = { root, NULL, NULL, 0, NULL, 1, 0 };
+    bench_run("encode_letter", "alphabet", ALPHABET_SIZE, ALPHABET_SIZE, run_encode_letter, &codec);
+    bench_run("decode_letter", "alphabet", ALPHABET_SIZE, ALPHABET_SIZE, run_decode_letter, &codec);
+
+    // A "char" is one element here
+    char label[24];
+    snprintf(label, sizeof(label), "%u nodes", (unsigned)NODE_BENCH_ELEMENTS);
+    size_t bytes = NODE_BENCH_ELEMENTS * sizeof(Node);
+    bench_run("Node stack push/pop", label, bytes, NODE_BENCH_ELEMENTS, run_node_stack, &codec);
+    bench_run("Node queue enque/deque", label, bytes, NODE_BENCH_ELEMENTS, run_node_queue, &codec);
+    bench_run("Node stack push_n/pop_n", label, bytes, NODE_BENCH_ELEMENTS, run_node_stack_n, &codec);
+    bench_run("Node queue enque_n/deque_n", label, bytes, NODE_BENCH_ELEMENTS, run_node_queue_n, &codec);
+}
+
+typedef struct CacheContext
+{
+    MorseEncodeCache* encode;
+    MorseDecodeCache* decode;
+    const char* input;
+    size_t length;
+} CacheContext;
+
+static void run_encode_table(void* context)
+{
+    CacheContext* cache = context;
+    free(morse_encode_n_with_table(&MORSE_ENCODE_TABLE_DEFAULT, cache->input, cache->length));
+}
+
+static void run_encode_cached(void* context)
+{
+    CacheContext* cache = context;
+    free(morse_encode_cached(cache->encode, cache->input, cache->length));
+}
+
+static void run_decode_table(void* context)
+{
+    CacheContext* cache = context;
+    size_t error_offset;
+    free(morse_decode_checked_with_table(&MORSE_DECODE_TABLE_DEFAULT, cache->input, cache->length,
+                                         MORSE_DECODE_STRICT, &error_offset));
+}
+
+static void run_decode_cached(void* context)
+{
+    CacheContext* cache = context;
+    size_t error_offset;
+    free(morse_decode_cached(cache->decode, cache->input, cache->length, MORSE_DECODE_STRICT, &error_offset));
+}
+
+static void print_cache_stats(const char* name, const MorseCacheStats* stats)
+{
+    printf("  %s cache: %.1f%% hits, %llu evictions, %llu bypasses\n", name,
+           100.0 * (double)stats->hits / (double)(stats->hits + stats->misses + stats->bypasses + 1),
+           (unsigned long long)stats->evictions, (unsigned long long)stats->bypasses);
+}
+
+// The word caches against the per-letter table paths, on repetitive traffic and on the English corpus;
+// decoding runs over the encoded corpus
+static void bench_word_cache(void)
+{
+    MorseEncodeCache encode;
+    MorseDecodeCache decode;
+    bool encode_ready = morse_encode_cache_init(&encode, &MORSE_ENCODE_TABLE_DEFAULT, MORSE_CACHE_DEFAULT_BUDGET);
+    bool decode_ready = morse_decode_cache_init(&decode, &MORSE_DECODE_TABLE_DEFAULT, MORSE_CACHE_DEFAULT_BUDGET);
+    if (!encode_ready || !decode_ready) {
+        fprintf(stderr, "Memory allocation failed\n");
+        morse_encode_cache_delete(&encode);
+        morse_decode_cache_delete(&decode);
+        return;
+    }
+    char* corpora[2] = { generate_traffic_corpus(CORPUS_SIZES[1]), generate_sized_corpus(CORPUS_ENGLISH, CORPUS_SIZES[1]) };
+    char labels[2][24];
+    snprintf(labels[0], sizeof(labels[0]), "traffic-%zuK", CORPUS_SIZES[1] / 1024u);
+    corpus_label(labels[1], sizeof(labels[1]), CORPUS_ENGLISH, CORPUS_SIZES[1]);
+    for (size_t c = 0; c < 2; c++) {
+        if (!corpora[c]) {
+            fprintf(stderr, "Memory allocation failed\n");
+            continue;
+        }
+        CacheContext cache = { &encode, &decode, corpora[c], strlen(corpora[c]) };
+        char* morse = morse_encode_n_with_table(&MORSE_ENCODE_TABLE_DEFAULT, cache.input, cache.length);
+        char* cached = morse_encode_cached(&encode, cache.input, cache.length);
+        if (!morse || !cached || strcmp(morse, cached) != 0) fprintf(stderr, "morse_encode_cached: output differs\n");
+        free(cached);
+
+        bench_run("morse_encode_n_with_table", labels[c], cache.length, cache.length, run_encode_table, &cache);
+        morse_encode_cache_clear(&encode);
+        bench_run("morse_encode_cached", labels[c], cache.length, cache.length, run_encode_cached, &cache);
+        print_cache_stats("encode", &encode.words.stats);
+
+        if (morse) {
+            size_t error_offset;
+            CacheContext coded = { &encode, &decode, morse, strlen(morse) };
+            char* plain = morse_decode_checked_with_table(&MORSE_DECODE_TABLE_DEFAULT, coded.input, coded.length,
+                                                          MORSE_DECODE_STRICT, &error_offset);
+            char* decoded = morse_decode_cached(&decode, coded.input, coded.length, MORSE_DECODE_STRICT, &error_offset);
+            if (!plain || !decoded || strcmp(plain, decoded) != 0) fprintf(stderr, "morse_decode_cached: output differs\n");
+            free(plain);
+            free(decoded);
+
+            bench_run("morse_decode_checked_with_table", labels[c], coded.length, coded.length, run_decode_table, &coded);
+            morse_decode_cache_clear(&decode);
+            bench_run("morse_decode_cached", labels[c], coded.length, coded.length, run_decode_cached, &coded);
+            print_cache_stats("decode", &decode.words.stats);
+        }
+        free(morse);
+        free(corpora[c]);
+    }
+    morse_encode_cache_delete(&encode);
+    morse_decode_cache_delete(&decode);
+}
+
+// Timing decoder over the English corpus as key events; a "char" is one event
+// Steady keying, then a sender who slows down 2.5 times halfway through
+static void bench_timing(const BTreeNode* root)
+{
+    char* text = generate_sized_corpus(CORPUS_ENGLISH, CORPUS_SIZES[1]);
+    char* morse = text ? morse_encode(root, text) : NULL;
+    size_t error_offset;
+    char* expected = morse ? morse_decode_checked(root, morse, strlen(morse), MORSE_DECODE_LENIENT, &error_offset) : NULL;
+    if (!expected) {
+        fprintf(stderr, "Memory allocation failed\n");
+    }
+    const double slowdowns[2] = { 1, 2.5 };
+    const char* names[2] = { "morse_timing_feed", "morse_timing_feed 2.5x slower" };
+    for (size_t s = 0; s < 2 && expected; s++) {
+        size_t count = 0;
+        double* events = generate_timing_events(morse, slowdowns[s], &count);
+        if (!events) {
+            fprintf(stderr, "Memory allocation failed\n");
+            break;
+        }
+        char label[24];
+        corpus_label(label, sizeof(label), CORPUS_ENGLISH, CORPUS_SIZES[1]);
+        TimingContext timing = { events, count, 0 };
+        bench_run(names[s], label, count * sizeof(double), count, run_timing_feed, &timing);
+        size_t words;
+        size_t matched = timing_words_decoded(events, count, expected, &words);
+        printf("  timing: %zu of %zu words decoded\n", matched, words);
+        free(events);
+    }
+    free(expected);
+    free(morse);
+    free(text);
+}
+
+// Nodes from a producer thread to a consumer through the SPSC queue and a mutex-guarded Node queue
+static void bench_pipeline(const BTreeNode* root)
+{
+    PipelineContext* pipeline = aligned_alloc(SPSC_CACHE_LINE, sizeof(PipelineContext));
+    if (!pipeline) {
+        fprintf(stderr, "Memory allocation failed\n");
+        return;
+    }
+    pipeline->root = root;
+    pipeline->checksum = 0;
+    Node_queue_init(&pipeline->locked);
+    pthread_mutex_init(&pipeline->lock, NULL);
+
+    char label[24];
+    snprintf(label, sizeof(label), "%u nodes", PIPELINE_ELEMENTS);
+    size_t bytes = PIPELINE_ELEMENTS * sizeof(Node);
+    pipeline->batch = 1;
+    bench_run("SPSC queue enque/deque", label, bytes, PIPELINE_ELEMENTS, run_spsc_pipeline, pipeline);
+    pipeline->batch = PIPELINE_BATCH;
+    bench_run("SPSC queue enque_n/deque_n", label, bytes, PIPELINE_ELEMENTS, run_spsc_pipeline, pipeline);
+    bench_run("mutex Node queue", label, bytes, PIPELINE_ELEMENTS, run_locked_pipeline, pipeline);
+
+    pthread_mutex_destroy(&pipeline->lock);
+    Node_queue_delete(&pipeline->locked);
+    free(pipeline);
+}
+
+static void bench_classify(const char* name, MorseClassifyFn classify, const char* corpus, size_t corpus_len)
+{
+    ClassifyContext scan = { classify, corpus, corpus_len, 0 };
+    char label[48];
+    snprintf(label, sizeof(label), "classify %s", name);
+    bench_run(label, "morse-4M", corpus_len, corpus_len, run_classify, &scan);
+}
+
+// Decoder variants and thread scaling on one large corpus of random words
+static void bench_decode(const BTreeNode* root)
+{
+    size_t corpus_len = 0;
+    char* corpus = generate_morse_corpus(CORPUS_LETTERS, &corpus_len);
+    char* scratch = malloc(corpus_len + 1);
+    if (!corpus || !scratch) {
+        fprintf(stderr, "Memory allocation failed\n");
+        free(corpus);
+        free(scratch);
+        return;
+    }
+    printf("decode corpus: %zu letters, %.1f MB\n", (size_t)CORPUS_LETTERS, (double)corpus_len / 1e6);
+
+    MorseDecodeTable table;
+    morse_decode_table_build(root, &table);
+    CodecContext codec = { root, &table, corpus, corpus_len, scratch, 1, 0 };
+    bench_run("decode (malloc per token)", "morse-4M", corpus_len, corpus_len, run_decode_copying_tokens, &codec);
+    bench_run("morse_decode_reference", "morse-4M", corpus_len, corpus_len, run_decode_reference, &codec);
+    bench_run("morse_decode", "morse-4M", corpus_len, corpus_len, run_morse_decode, &codec);
+    bench_run("morse_decode_into", "morse-4M", corpus_len, corpus_len, run_decode_into, &codec);
+
+    char* serial = morse_decode(root, corpus);
+    static const size_t THREAD_COUNTS[] = { 1, 2, 4, 8 };
+    for (size_t t = 0; t < sizeof(THREAD_COUNTS) / sizeof(THREAD_COUNTS[0]); t++) {
+        char name[64];
+        snprintf(name, sizeof(name), "morse_decode_parallel -j %zu", THREAD_COUNTS[t]);
+        char* decoded = morse_decode_parallel(root, corpus, corpus_len, THREAD_COUNTS[t], MORSE_DECODE_SKIP, NULL);
+        if (!decoded || !serial || strcmp(decoded, serial) != 0) {
+            fprintf(stderr, "%s: output differs from morse_decode\n", name);
+        }
+        free(decoded);
+        codec.threads = THREAD_COUNTS[t];
+        bench_run(name, "morse-4M", corpus_len, corpus_len, run_decode_parallel, &codec);
+    }
+    free(serial);
+
+    printf("selected classifier: %s\n", morse_classify_name(morse_classify_select()));
+    bench_classify("scalar", morse_classify_scalar, corpus, corpus_len);
+#if defined(__x86_64__)
+    bench_classify("sse2", morse_classify_sse2, corpus, corpus_len);
+    if (morse_classify_select() == morse_classify_avx2) {
+        bench_classify("avx2", morse_classify_avx2, corpus, corpus_len);
+    }
+#endif
+
+    free(scratch);
+    free(corpus);
+}
+
+static void bench_encode(const BTreeNode* root)
+{
+    size_t corpus_len = 0;
+    char* corpus = generate_text_corpus(CORPUS_LETTERS, &corpus_len);
+    if (!corpus) {
+        fprintf(stderr, "Memory allocation failed\n");
+        return;
+    }
+    printf("encode corpus: %zu letters, %.1f MB\n", (size_t)CORPUS_LETTERS, (double)corpus_len / 1e6);
+
+    CodecContext codec = { root, NULL, corpus, corpus_len, NULL, 1, 0 };
+    bench_run("morse_encode", "text-4M", corpus_len, corpus_len, run_morse_encode, &codec);
+
+    char* serial = morse_encode(root, corpus);
+    static const size_t THREAD_COUNTS[] = { 1, 2, 4, 8 };
+    for (size_t t = 0; t < sizeof(THREAD_COUNTS) / sizeof(THREAD_COUNTS[0]); t++) {
+        char name[64];
+        snprintf(name, sizeof(name), "morse_encode_parallel -j %zu", THREAD_COUNTS[t]);
+        char* encoded = morse_encode_parallel(root, corpus, corpus_len, THREAD_COUNTS[t]);
+        if (!encoded || !serial || strcmp(encoded, serial) != 0) {
+            fprintf(stderr, "%s: output differs from morse_encode\n", name);
+        }
+        free(encoded);
+        codec.threads = THREAD_COUNTS[t];
+        bench_run(name, "text-4M", corpus_len, corpus_len, run_encode_parallel, &codec);
+    }
+
+    free(serial);
+    free(corpus);
+}
+
+static bool write_csv(const char* path)
+{
+    FILE* file = fopen(path, "w");
+    if (!file) return false;
+    fprintf(file, "name,corpus,bytes,chars,mb_per_s,ns_per_char,allocs_per_op\n");
+    for (size_t i = 0; i < result_count; i++) {
+        const BenchResult* result = &results[i];
+        fprintf(file, "%s,%s,%zu,%zu,%.3f,%.3f,", result->name, result->corpus, result->bytes, result->chars,
+                (double)result->bytes / result->seconds / 1e6, result->seconds * 1e9 / (double)result->chars);
+        if (result->allocations >= 0) fprintf(file, "%.3f", result->allocations);
+        fprintf(file, "\n");
+    }
+    return fclose(file) == 0;
+}
+
+static bool write_json(const char* path)
+{
+    FILE* file = fopen(path, "w");
+    if (!file) return false;
+    fprintf(file, "{\n  \"classifier\": \"%s\",\n  \"results\": [\n", morse_classify_name(morse_classify_select()));
+    for (size_t i = 0; i < result_count; i++) {
+        const BenchResult* result = &results[i];
+        fprintf(file, "    {\"name\": \"%s\", \"corpus\": \"%s\", \"bytes\": %zu, \"chars\": %zu, "
+                      "\"mb_per_s\": %.3f, \"ns_per_char\": %.3f, \"allocs_per_op\": ",
+                result->name, result->corpus, result->bytes, result->chars,
+                (double)result->bytes / result->seconds / 1e6, result->seconds * 1e9 / (double)result->chars);
+        if (result->allocations >= 0) fprintf(file, "%.3f}", result->allocations);
+        else fprintf(file, "null}");
+        fprintf(file, "%s\n", i + 1 < result_count ? "," : "");
+    }
+    fprintf(file, "  ]\n}\n");
+    return fclose(file) == 0;
+}
+
+static void print_usage(const char* program)
+{
+    printf("Usage: %s [--csv FILE] [--json FILE]\n", program);
+    printf("  --csv FILE   Also write every result as CSV\n");
+    printf("  --json FILE  Also write every result as JSON\n");
+}
+
+
+int main(int argc, char* argv[])
+{
+    const char* csv_path = NULL;
+    const char* json_path = NULL;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--csv") == 0 && i + 1 < argc) csv_path = argv[++i];
+        else if (strcmp(argv[i], "--json") == 0 && i + 1 < argc) json_path = argv[++i];
+        else {
+            print_usage(argv[0]);
+            return strcmp(argv[i], "-h") == 0 || strcmp(argv[i], "--help") == 0 ? 0 : 1;
+        }
+    }
+
+    BTreeNode* root = morse_tree_init();
+    if (!root) {
+        fprintf(stderr, "Memory error\n");
+        return 1;
+    }
+    for (size_t i = 0; i < ALPHABET_SIZE; i++) {
+        morse_tree_insert(root, MORSE_CODE_SEQUENCE[i], ALPHABET[i]);
+    }
+
+    if (!ALLOCATIONS_COUNTED) printf("allocation counting disabled (build with make bench)\n");
+    bench_corpora(root);
+    bench_letters(root);
+    bench_word_cache();
+    bench_timing(root);
+    bench_pipeline(root);
+    bench_decode(root);
+    bench_encode(root);
+    morse_tree_delete(root);
+
+    int status = 0;
+    if (csv_path && !write_csv(csv_path)) {
+        fprintf(stderr, "%s: cannot write results\n", csv_path);
+        status = 1;
+    }
+    if (json_path && !write_json(json_path)) {
+        fprintf(stderr, "%s: cannot write results\n", json_path);
+        status = 1;
+    }
+    return status;
+}
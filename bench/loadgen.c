@@ -0,0 +1,166 @@
+#define _POSIX_C_SOURCE 200809L
+#include "morse-server.h"
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+
+// Load generator for the translation server: every connection runs on its own thread
+// and keeps up to `depth` requests in flight, latency is measured per request.
+
+typedef struct Worker
+{
+    pthread_t thread;
+    const char* socket_path;
+    char operation;
+    const char* message;
+    size_t message_len;
+    size_t requests;
+    size_t depth;
+    uint64_t* latencies; // nanoseconds, one per request
+    size_t completed;
+    bool failed;
+    bool started; // thread created, so it must be joined
+} Worker;
+
+static uint64_t now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+static void* worker_run(void* argument)
+{
+    Worker* worker = argument;
+    MorseClient* client = malloc(sizeof(MorseClient));
+    uint64_t* sent_at = malloc(worker->depth * sizeof(uint64_t));
+    MorseResponse response = { 0, NULL, 0, 0 };
+    if (!client || !sent_at || !morse_client_connect(client, worker->socket_path))
+    {
+        worker->failed = true;
+        free(client);
+        free(sent_at);
+        return NULL;
+    }
+
+    // Responses arrive in request order, so send times form a FIFO ring
+    size_t sent = 0;
+    while (worker->completed < worker->requests)
+    {
+        while (sent < worker->requests && sent - worker->completed < worker->depth)
+        {
+            sent_at[sent % worker->depth] = now_ns();
+            if (!morse_client_send(client, worker->operation, worker->message, worker->message_len)) break;
+            sent++;
+        }
+        if (!morse_client_receive(client, &response) || response.status != MORSE_STATUS_OK)
+        {
+            worker->failed = true;
+            break;
+        }
+        worker->latencies[worker->completed] = now_ns() - sent_at[worker->completed % worker->depth];
+        worker->completed++;
+    }
+
+    morse_response_free(&response);
+    morse_client_close(client);
+    free(client);
+    free(sent_at);
+    return NULL;
+}
+
+static int compare_u64(const void* a, const void* b)
+{
+    uint64_t x = *(const uint64_t*)a;
+    uint64_t y = *(const uint64_t*)b;
+    return (x > y) - (x < y);
+}
+
+static void print_usage(const char* program)
+{
+    printf("Usage: %s [options] SOCKET\n", program);
+    printf("  -c N        Connections, one thread each (default 4)\n");
+    printf("  -n N        Requests per connection (default 100000)\n");
+    printf("  -p N        Requests in flight per connection (default 16)\n");
+    printf("  -e, -d      Send encode or decode requests (default decode)\n");
+    printf("  -m MESSAGE  Request payload\n");
+}
+
+int main(int argc, char* argv[])
+{
+    size_t connections = 4;
+    size_t requests = 100000;
+    size_t depth = 16;
+    char operation = MORSE_REQUEST_DECODE;
+    const char* message = NULL;
+
+    int option;
+    while ((option = getopt(argc, argv, "c:n:p:edm:h")) != -1) {
+        switch (option) {
+            case 'c': connections = strtoul(optarg, NULL, 10); break;
+            case 'n': requests = strtoul(optarg, NULL, 10); break;
+            case 'p': depth = strtoul(optarg, NULL, 10); break;
+            case 'e': operation = MORSE_REQUEST_ENCODE; break;
+            case 'd': operation = MORSE_REQUEST_DECODE; break;
+            case 'm': message = optarg; break;
+            case 'h': print_usage(argv[0]); return 0;
+            default: print_usage(argv[0]); return 1;
+        }
+    }
+    if (optind >= argc || connections == 0 || requests == 0 || depth == 0) {
+        print_usage(argv[0]);
+        return 1;
+    }
+    if (!message) {
+        message = operation == MORSE_REQUEST_ENCODE
+            ? "THE QUICK BROWN FOX JUMPS OVER THE LAZY DOG 1234567890"
+            : "- .... . / --.- ..- .. -.-. -.- / -... .-. --- .-- -. / ..-. --- -..- / .---- ..--- ...--";
+    }
+
+    Worker* workers = calloc(connections, sizeof(Worker));
+    uint64_t* latencies = malloc(connections * requests * sizeof(uint64_t));
+    if (!workers || !latencies) {
+        fprintf(stderr, "Memory allocation failed\n");
+        free(workers);
+        free(latencies);
+        return 1;
+    }
+
+    uint64_t start = now_ns();
+    for (size_t i = 0; i < connections; i++) {
+        workers[i] = (Worker){ .socket_path = argv[optind], .operation = operation, .message = message,
+                               .message_len = strlen(message), .requests = requests, .depth = depth,
+                               .latencies = latencies + i * requests };
+        workers[i].started = pthread_create(&workers[i].thread, NULL, worker_run, &workers[i]) == 0;
+        workers[i].failed = !workers[i].started;
+    }
+
+    size_t total = 0;
+    bool failed = false;
+    for (size_t i = 0; i < connections; i++) {
+        if (workers[i].started) pthread_join(workers[i].thread, NULL);
+        // Pack the completed latencies together
+        memmove(latencies + total, workers[i].latencies, workers[i].completed * sizeof(uint64_t));
+        total += workers[i].completed;
+        failed = failed || workers[i].failed;
+    }
+    double seconds = (double)(now_ns() - start) * 1e-9;
+
+    if (failed) fprintf(stderr, "Some connections failed, reporting completed requests only\n");
+    if (total > 0) {
+        qsort(latencies, total, sizeof(uint64_t), compare_u64);
+        printf("requests:    %zu over %zu connections, %zu in flight each\n", total, connections, depth);
+        printf("throughput:  %.0f requests/s\n", (double)total / seconds);
+        printf("latency p50: %.1f us\n", (double)latencies[total / 2] / 1e3);
+        printf("latency p99: %.1f us\n", (double)latencies[total * 99 / 100] / 1e3);
+        printf("latency max: %.1f us\n", (double)latencies[total - 1] / 1e3);
+    }
+
+    free(workers);
+    free(latencies);
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,35 @@
+#ifndef __ALLOCATOR_H
+#define __ALLOCATOR_H
+
+#include <stddef.h>
+
+
+/**
+ * Allocator context
+ * -----------------
+ * A malloc/realloc/free triple with the user data it runs against, for
+ * containers generated with GENERATE_STACK_WITH_ALLOCATOR(...) and
+ * GENERATE_QUEUE_WITH_ALLOCATOR(...), so each container instance can draw
+ * from its own arena or pool.
+ *
+ * Usage:
+ *   Allocator scratch_allocator = arena_allocator(&scratch);
+ *   stack_init_with_allocator(Node, &stack, &scratch_allocator);
+ *
+ * Notes:
+ *   The allocator must outlive every container that uses it.
+ *   Containers only call it when they grow or shrink, never per element.
+ */
+typedef struct Allocator
+{
+   void *(*alloc)(void *context, size_t size);
+   void *(*realloc)(void *context, void *ptr, size_t size);
+   void (*free)(void *context, void *ptr);
+   void *context;
+} Allocator;
+
+// malloc, realloc and free
+extern const Allocator ALLOCATOR_MALLOC;
+
+
+#endif /* __ALLOCATOR_H */
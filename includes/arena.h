@@ -0,0 +1,78 @@
+#ifndef __ARENA_H
+#define __ARENA_H
+
+#include "allocator.h"
+#include <stddef.h>
+
+
+/**
+ * Arena allocator
+ * ---------------
+ * Bump allocator over a chain of heap blocks. Allocations are carved from
+ * the newest block and released all at once by arena_delete().
+ *
+ * Usage:
+ *   Arena arena;
+ *   arena_init(&arena, ARENA_DEFAULT_BLOCK_SIZE);
+ *   char* buffer = arena_alloc(&arena, 64);
+ *   arena_delete(&arena);              // Frees every allocation
+ *
+ * Notes:
+ *   Allocations are aligned for any type (max_align_t).
+ *   arena_free() only reclaims the most recent allocation; anything else
+ *   lives until arena_reset() or arena_delete().
+ *   Requests larger than the block size get a block of their own.
+ */
+#define ARENA_DEFAULT_BLOCK_SIZE 4096
+
+typedef struct ArenaBlock
+{
+   struct ArenaBlock *next;
+   size_t capacity;
+   size_t used;
+   max_align_t data[];
+} ArenaBlock;
+
+typedef struct Arena
+{
+   ArenaBlock *head; // newest block, allocations are carved from it
+   void *last; // most recent allocation, the only one that can grow in place or be freed
+   size_t block_size;
+   size_t blocks; // heap allocations made so far
+} Arena;
+
+void arena_init(Arena *const arena, size_t block_size);
+void *arena_alloc(Arena *const arena, size_t size);
+void *arena_realloc(Arena *const arena, void *ptr, size_t size);
+void arena_free(Arena *const arena, void *ptr);
+void arena_reset(Arena *const arena);
+void arena_delete(Arena *const arena);
+// Allocator context drawing from `arena`, which must outlive it
+Allocator arena_allocator(Arena *const arena);
+
+
+/**
+ * Thread arena hooks
+ * ------------------
+ * malloc/realloc/free shaped functions that draw from the arena bound to
+ * the calling thread, for the alloc_fn/realloc_fn/free_fn parameters of
+ * GENERATE_STACK(...) and GENERATE_QUEUE(...).
+ *
+ * Usage:
+ *   Arena* previous = arena_thread_bind(&scratch);
+ *   ...                                // Containers grow inside `scratch`
+ *   arena_thread_bind(previous);
+ *
+ * Notes:
+ *   With no arena bound the hooks fall back to malloc, realloc and free.
+ *   A container must be deleted under the binding it grew under.
+ *   ARENA_THREAD_ALLOCATOR wraps the same hooks as an Allocator context.
+ */
+Arena *arena_thread_bind(Arena *const arena);
+void *arena_thread_alloc(size_t size);
+void *arena_thread_realloc(void *ptr, size_t size);
+void arena_thread_free(void *ptr);
+extern const Allocator ARENA_THREAD_ALLOCATOR;
+
+
+#endif /* __ARENA_H */
@@ -0,0 +1,137 @@
+#ifndef MORSE_AUDIO_H
+#define MORSE_AUDIO_H
+
+#include "morse.h"
+#include "morse-timing.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+
+/**
+ * Audio synthesis
+ * ---------------
+ * Renders Morse text (dots, dashes, ' ' between letters, '/' between words,
+ * as written by morse_encode) to mono 16-bit little-endian PCM.
+ *
+ * Usage:
+ *   MorseAudioConfig config = MORSE_AUDIO_CONFIG_DEFAULT;
+ *   MorseAudio audio;
+ *   if (!morse_audio_init(&audio, &config)) { ... }
+ *   morse_audio_feed(&audio, morse, strlen(morse), write_fn, context);
+ *   morse_audio_finish(&audio);
+ *   morse_audio_delete(&audio);
+ *
+ * Notes:
+ *   Timing follows the PARIS standard: a dot lasts 1.2 / wpm seconds, a dash
+ *   three dots, and the gaps inside a letter, between letters and between
+ *   words one, three and seven dots. A Farnsworth speed below `wpm` keeps the
+ *   letters at `wpm` and stretches only the letter and word gaps, so the
+ *   text as a whole runs at the Farnsworth speed.
+ *   The dot and dash waveforms, raised-cosine edges included, are rendered
+ *   once by morse_audio_init; feeding only copies them and zeros out, so
+ *   rendering is bound by the writer. Gaps are written when the next
+ *   element arrives, so a message ends with its last element and the
+ *   renderer holds no samples between calls.
+ */
+#define MORSE_AUDIO_WAV_HEADER_SIZE 44
+#define MORSE_AUDIO_STREAMING UINT64_MAX // sample count for a WAV of unknown length
+
+typedef struct MorseAudioConfig
+{
+    unsigned sample_rate;   // Hz
+    double wpm;             // character speed
+    double farnsworth_wpm;  // overall speed, 0 (or >= wpm) for none
+    double frequency;       // tone, Hz, below half the sample rate
+    double rise_time;       // seconds of raised-cosine edge at each end of an element
+    double amplitude;       // peak, 0 to 1 of full scale
+} MorseAudioConfig;
+
+#define MORSE_AUDIO_CONFIG_DEFAULT { 8000, 20.0, 0.0, 600.0, 0.005, 0.8 }
+
+typedef enum MorseAudioGap
+{
+    MORSE_AUDIO_GAP_NONE,     // start of message
+    MORSE_AUDIO_GAP_ELEMENT,
+    MORSE_AUDIO_GAP_LETTER,
+    MORSE_AUDIO_GAP_WORD
+} MorseAudioGap;
+
+typedef struct MorseAudio
+{
+    MorseAudioConfig config;
+    unsigned char* dot;     // cached PCM bytes of one dot
+    unsigned char* dash;
+    size_t dot_samples;
+    size_t dash_samples;
+    size_t gap_samples[4];  // indexed by MorseAudioGap
+    MorseAudioGap pending;  // gap owed before the next element
+    uint64_t samples;       // rendered since init or the last finish
+} MorseAudio;
+
+// Receives rendered PCM bytes in order, returns false to stop rendering
+typedef bool (*MorseAudioWriteFn)(void* context, const void* data, size_t bytes);
+
+// Returns false when the config is out of range or the waveforms cannot be allocated
+bool morse_audio_init(MorseAudio* audio, const MorseAudioConfig* config);
+void morse_audio_delete(MorseAudio* audio);
+// Render one chunk, a message may span chunks. A NULL `write` only counts samples.
+// Returns false when `write` fails.
+bool morse_audio_feed(MorseAudio* audio, const char* morse, size_t length, MorseAudioWriteFn write, void* context);
+// End the message, returns its length in samples
+uint64_t morse_audio_finish(MorseAudio* audio);
+// WAV header for `samples` samples, or MORSE_AUDIO_STREAMING when the length is not known
+void morse_audio_wav_header(const MorseAudio* audio, uint64_t samples, unsigned char* header);
+
+
+/**
+ * Audio decoding
+ * --------------
+ * Reads mono 16-bit little-endian PCM and writes the decoded text.
+ *
+ * Usage:
+ *   MorseAudioDecoder decoder;
+ *   morse_audio_decoder_init(&decoder, &MORSE_DECODE_TABLE_DEFAULT, 8000, 600.0);
+ *   len = morse_audio_decoder_feed(&decoder, pcm, bytes, output);  // MORSE_AUDIO_DECODER_FEED_BOUND(bytes)
+ *   len = morse_audio_decoder_finish(&decoder, output);
+ *
+ * Notes:
+ *   A Goertzel filter measures the tone's magnitude in blocks of 5 ms.
+ *   The key is down while the magnitude stays above the midpoint between
+ *   the tracked signal peak and noise floor, with some hysteresis, so the
+ *   input level does not matter. Each block is one key event for a
+ *   MorseTimingDecoder (includes/morse-timing.h), which learns the speed
+ *   and spacing and writes a letter once the gap after it is long enough,
+ *   so no Morse text is built. The decoder keeps no samples, only a fixed
+ *   amount of state per channel.
+ */
+#define MORSE_AUDIO_DECODER_BLOCK_SECONDS 0.005
+#define MORSE_AUDIO_DECODER_MIN_BLOCK 8 // samples
+// Two bytes per block, plus a letter split again when the speed estimate drops
+#define MORSE_AUDIO_DECODER_FEED_BOUND(bytes) ((bytes) / MORSE_AUDIO_DECODER_MIN_BLOCK + 2 * MORSE_CODE_MAX_LENGTH + 6)
+#define MORSE_AUDIO_DECODER_FINISH_BOUND MORSE_TIMING_EVENT_BOUND
+
+typedef struct MorseAudioDecoder
+{
+    double coefficient;     // Goertzel 2cos(2 pi f / rate)
+    size_t block_samples;
+    size_t filled;          // samples in the current block
+    double s1, s2;
+    int low_byte;           // first byte of a sample split across chunks, -1 if none
+    double signal;          // tracked peak magnitude, 0 to 1
+    double noise;           // tracked floor magnitude
+    double decay;           // per block decay of `signal`
+    bool key_down;
+    MorseTimingDecoder timing; // fed one event per block
+} MorseAudioDecoder;
+
+// Returns false when the rate or tone is out of range; `table` must outlive the decoder
+bool morse_audio_decoder_init(MorseAudioDecoder* decoder, const MorseDecodeTable* table,
+                              unsigned sample_rate, double frequency);
+// Decode one chunk of PCM bytes, samples may span chunks; returns the bytes written
+size_t morse_audio_decoder_feed(MorseAudioDecoder* decoder, const void* pcm, size_t bytes, char* output);
+// Flush the letter in progress, returns the bytes written
+size_t morse_audio_decoder_finish(MorseAudioDecoder* decoder, char* output);
+
+
+#endif // MORSE_AUDIO_H
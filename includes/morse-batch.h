@@ -0,0 +1,40 @@
+#ifndef MORSE_BATCH_H
+#define MORSE_BATCH_H
+
+#include "morse.h"
+#include <stddef.h>
+
+
+/**
+ * Batch translation
+ * -----------------
+ * Translates many files in one process on a work-stealing thread pool.
+ * Each input is written to a sibling file named after it plus a suffix.
+ *
+ * Usage:
+ *   const char* paths[] = { "a.txt", "b.txt" };
+ *   size_t failed = morse_batch_run(paths, 2, MORSE_BATCH_DECODE, NULL, 8, &encode, &decode);
+ *
+ * Notes:
+ *   Every worker starts with an even, contiguous share of the paths and
+ *   takes them in order. An idle worker steals the back half of another
+ *   worker's remaining share, so a few large files cannot leave cores idle.
+ *   Decoding is strict: files with invalid bytes are reported on stderr
+ *   and get no output file. Trailing newlines of the input are ignored
+ *   and every output ends with one.
+ */
+#define MORSE_BATCH_DECODE_SUFFIX ".decoded"
+#define MORSE_BATCH_ENCODE_SUFFIX ".morse"
+
+typedef enum MorseBatchMode
+{
+    MORSE_BATCH_DECODE,
+    MORSE_BATCH_ENCODE
+} MorseBatchMode;
+
+// Returns the number of files that could not be translated; a NULL suffix picks the mode's default
+size_t morse_batch_run(const char* const* paths, size_t count, MorseBatchMode mode, const char* suffix,
+                       size_t threads, const MorseEncodeTable* encode_table, const MorseDecodeTable* decode_table);
+
+
+#endif // MORSE_BATCH_H
@@ -0,0 +1,117 @@
+#ifndef MORSE_CACHE_H
+#define MORSE_CACHE_H
+
+#include "morse.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+
+/**
+ * Word caches
+ * -----------
+ * Remember the translation of recently seen words, so traffic made of a
+ * small vocabulary (callsigns, Q-codes, CQ, DE, 73) is copied word by
+ * word instead of translated letter by letter.
+ *
+ * Usage:
+ *   MorseEncodeCache cache;
+ *   if (!morse_encode_cache_init(&cache, &MORSE_ENCODE_TABLE_DEFAULT, MORSE_CACHE_DEFAULT_BUDGET)) { ... }
+ *   char* morse = morse_encode_cached(&cache, text, length);   // same output as morse_encode_n
+ *   printf("%" PRIu64 " hits\n", cache.words.stats.hits);
+ *   morse_encode_cache_delete(&cache);
+ *
+ *   MorseDecodeCache decode;
+ *   morse_decode_cache_init(&decode, &MORSE_DECODE_TABLE_DEFAULT, MORSE_CACHE_DEFAULT_BUDGET);
+ *   char* text = morse_decode_cached(&decode, morse, length, MORSE_DECODE_STRICT, &error_offset);
+ *
+ * Notes:
+ *   The cache takes one allocation of at most `budget` bytes at init and
+ *   never grows. It holds a power of two of entries, each a fixed-size
+ *   slab slot with the word and its translation; words too long for a
+ *   slot are translated directly and counted as bypasses. Words are found
+ *   through an open-addressing index of twice as many slots, probed
+ *   linearly from a 64-bit hash of the word. Once the slab is full a
+ *   CLOCK hand picks the victim: it skips, and clears, entries hit since
+ *   its last pass, and the victim leaves the index by backward-shift
+ *   deletion, so the index never fills with tombstones.
+ *   A text word is a run of bytes up to and including a space, so a word
+ *   and its gap take one lookup. A translation depends only on its word,
+ *   so the output is byte-identical to the uncached codec whatever the
+ *   cache holds. Hits are copied in whole 16-byte blocks, hence the
+ *   output slack.
+ *   A Morse word runs up to and including a '/' and the spaces after it.
+ *   Only words of '.', '-' and spaces are cached; one with any other byte
+ *   is decoded directly, so every decode mode shares the cache and strict
+ *   decoding still reports the first invalid byte.
+ *   A cache is not thread-safe: use one per thread. The table must outlive
+ *   the cache.
+ */
+#define MORSE_CACHE_DEFAULT_BUDGET (256 * 1024) // bytes
+#define MORSE_CACHE_MIN_ENTRIES 16
+#define MORSE_CACHE_OUTPUT_SLACK 16 // bytes past the output a cached copy may write
+#define MORSE_ENCODE_CACHE_WORD_MAX 16 // longest text word cached, with the space after it
+#define MORSE_DECODE_CACHE_WORD_MAX 48 // longest Morse word cached, with its separator
+
+typedef struct MorseCacheStats
+{
+    uint64_t hits;
+    uint64_t misses;    // words translated and inserted
+    uint64_t evictions;
+    uint64_t bypasses;  // words too long to cache, or with invalid bytes
+} MorseCacheStats;
+
+typedef struct MorseCacheEntry
+{
+    uint64_t hash;
+    uint16_t key_length;
+    uint16_t value_length;
+    bool referenced;    // hit since the CLOCK hand last passed
+} MorseCacheEntry;
+
+typedef struct MorseWordCache
+{
+    MorseCacheEntry* entries;
+    uint32_t* index;    // entry + 1 per slot, 0 when free
+    char* slab;         // one slot per entry: the key, then the value
+    size_t capacity;    // entries, a power of two
+    size_t used;
+    size_t hand;        // CLOCK position
+    size_t key_max;
+    size_t slot_size;
+    MorseCacheStats stats;
+} MorseWordCache;
+
+typedef struct MorseEncodeCache
+{
+    const MorseEncodeTable* table;
+    MorseWordCache words;
+} MorseEncodeCache;
+
+typedef struct MorseDecodeCache
+{
+    const MorseDecodeTable* table;
+    MorseWordCache words;
+} MorseDecodeCache;
+
+// Returns false when the budget holds fewer than MORSE_CACHE_MIN_ENTRIES words or cannot be allocated
+bool morse_encode_cache_init(MorseEncodeCache* cache, const MorseEncodeTable* table, size_t budget);
+void morse_encode_cache_delete(MorseEncodeCache* cache);
+// Forget every word, the statistics included
+void morse_encode_cache_clear(MorseEncodeCache* cache);
+// As morse_encode_span, returns the bytes written; `output` is sized with morse_encoded_length
+// plus MORSE_CACHE_OUTPUT_SLACK
+size_t morse_encode_cache_span(MorseEncodeCache* cache, const char* text_message, size_t length, char* output);
+// As morse_encode_n_with_table, the result is malloc'd
+char* morse_encode_cached(MorseEncodeCache* cache, const char* text_message, size_t length);
+
+// As for the encode cache
+bool morse_decode_cache_init(MorseDecodeCache* cache, const MorseDecodeTable* table, size_t budget);
+void morse_decode_cache_delete(MorseDecodeCache* cache);
+void morse_decode_cache_clear(MorseDecodeCache* cache);
+// As morse_decode_checked_with_table, the result is malloc'd
+char* morse_decode_cached(MorseDecodeCache* cache, const char* morse_message, size_t message_len,
+                          MorseDecodeMode mode, size_t* error_offset);
+
+
+#endif // MORSE_CACHE_H
@@ -0,0 +1,42 @@
+#ifndef MORSE_PARALLEL_H
+#define MORSE_PARALLEL_H
+
+#include "morse.h"
+#include <stddef.h>
+
+
+/**
+ * Chunk-parallel translation
+ * --------------------------
+ * Splits a message into one chunk per thread and translates the chunks
+ * concurrently. The output is byte-identical to the serial functions.
+ *
+ * Usage:
+ *   size_t error_offset;
+ *   char* text = morse_decode_parallel(root, message, length, 4, MORSE_DECODE_STRICT, &error_offset);
+ *
+ * Notes:
+ *   Morse input is split just after a '/' word separator, so no letter
+ *   spans two chunks. Text is split anywhere: a sizing pass and a prefix
+ *   sum give every thread its slice of one exactly-sized output buffer.
+ *   Messages shorter than MORSE_PARALLEL_MIN_CHUNK per thread use fewer
+ *   threads, down to the serial path.
+ *   The calling thread translates the first chunk; the others go to a
+ *   pool of worker threads started on first use and kept, idle, for the
+ *   life of the process. Concurrent calls take turns on the pool.
+ */
+#ifndef MORSE_PARALLEL_MIN_CHUNK
+#define MORSE_PARALLEL_MIN_CHUNK (64 * 1024)
+#endif
+#define MORSE_PARALLEL_MAX_THREADS 256
+
+char* morse_decode_parallel(const BTreeNode* root, const char* morse_message, size_t message_len, size_t threads,
+                            MorseDecodeMode mode, size_t* error_offset);
+char* morse_decode_parallel_with_table(const MorseDecodeTable* table, const char* morse_message, size_t message_len,
+                                       size_t threads, MorseDecodeMode mode, size_t* error_offset);
+char* morse_encode_parallel(const BTreeNode* root, const char* text_message, size_t message_len, size_t threads);
+char* morse_encode_parallel_with_table(const MorseEncodeTable* table, const char* text_message, size_t message_len,
+                                       size_t threads);
+
+
+#endif // MORSE_PARALLEL_H
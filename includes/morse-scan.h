@@ -0,0 +1,75 @@
+#ifndef MORSE_SCAN_H
+#define MORSE_SCAN_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+
+/**
+ * Morse input classification
+ * --------------------------
+ * Classifies a block of MORSE_SCAN_BLOCK bytes into one bitmask per
+ * symbol class; bit i describes byte i of the block.
+ *
+ * Usage:
+ *   MorseClassifyFn classify = morse_classify_select();
+ *   MorseBlockMasks masks;
+ *   classify(block, &masks);
+ *
+ * Notes:
+ *   The classifier always reads a full block; callers pad the tail of
+ *   their input. morse_classify_select() picks AVX2, SSE2 or the
+ *   portable scalar loop depending on what the running CPU supports.
+ *   The vector classifiers are only built for x86-64, where SSE2 is
+ *   always present; other targets, 32-bit x86 included, use the scalar
+ *   loop.
+ */
+#define MORSE_SCAN_BLOCK 64
+
+typedef struct MorseBlockMasks
+{
+    uint64_t dot; // '.'
+    uint64_t dash; // '-'
+    uint64_t space; // ' '
+    uint64_t slash; // '/'
+} MorseBlockMasks;
+
+typedef void (*MorseClassifyFn)(const char* block, MorseBlockMasks* masks);
+
+void morse_classify_scalar(const char* block, MorseBlockMasks* masks);
+#if defined(__x86_64__)
+void morse_classify_sse2(const char* block, MorseBlockMasks* masks);
+void morse_classify_avx2(const char* block, MorseBlockMasks* masks);
+#endif
+
+MorseClassifyFn morse_classify_select(void);
+const char* morse_classify_name(MorseClassifyFn classify);
+
+
+/**
+ * Bit scan helpers
+ * ----------------
+ * Count trailing zeros (undefined for 0) and population count of a mask.
+ */
+#if defined(__GNUC__) || defined(__clang__)
+   #define MORSE_CTZ64(mask) ((size_t)__builtin_ctzll(mask))
+   #define MORSE_POPCOUNT64(mask) ((size_t)__builtin_popcountll(mask))
+#else
+static inline size_t morse_ctz64(uint64_t mask)
+{
+   size_t n = 0;
+   while (!(mask & 1u)) { mask >>= 1; n++; }
+   return n;
+}
+static inline size_t morse_popcount64(uint64_t mask)
+{
+   size_t n = 0;
+   for (; mask; mask &= mask - 1) n++;
+   return n;
+}
+   #define MORSE_CTZ64(mask) morse_ctz64(mask)
+   #define MORSE_POPCOUNT64(mask) morse_popcount64(mask)
+#endif
+
+
+#endif // MORSE_SCAN_H
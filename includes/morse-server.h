@@ -0,0 +1,71 @@
+#ifndef MORSE_SERVER_H
+#define MORSE_SERVER_H
+
+#include "morse.h"
+#include <stddef.h>
+#include <stdint.h>
+
+
+/**
+ * Translation server protocol
+ * ---------------------------
+ * Length-prefixed frames over a Unix stream socket. A request is a 1-byte
+ * operation followed by a 4-byte big-endian payload length and the payload;
+ * a response is a 1-byte status, a 4-byte big-endian length and the payload.
+ *
+ * Usage:
+ *   MorseClient client;
+ *   morse_client_connect(&client, "/tmp/morse.sock");
+ *   morse_client_send(&client, MORSE_REQUEST_DECODE, "... --- ...", 11);
+ *   MorseResponse response = { 0, NULL, 0, 0 };
+ *   morse_client_receive(&client, &response);  // response.payload is "SOS"
+ *   morse_response_free(&response);
+ *   morse_client_close(&client);
+ *
+ * Notes:
+ *   Requests may be pipelined: a client can send any number of frames
+ *   before reading, and responses come back in request order.
+ *   Decoding is strict; an invalid byte gets MORSE_STATUS_INVALID with a
+ *   message naming its offset. Payloads over MORSE_SERVER_MAX_PAYLOAD
+ *   close the connection.
+ */
+#define MORSE_FRAME_HEADER_SIZE 5
+#define MORSE_SERVER_MAX_PAYLOAD (16u * 1024u * 1024u)
+
+#define MORSE_REQUEST_ENCODE 'E'
+#define MORSE_REQUEST_DECODE 'D'
+
+#define MORSE_STATUS_OK 0
+#define MORSE_STATUS_INVALID 1 // the message holds bytes that cannot be translated
+#define MORSE_STATUS_ERROR 2 // unknown operation or server failure
+
+// Serve requests on `socket_path` until SIGINT or SIGTERM, returns 0 on a clean shutdown
+int morse_server_run(const char* socket_path, const MorseEncodeTable* encode_table,
+                     const MorseDecodeTable* decode_table);
+
+
+// Blocking client connection with a buffered reader
+typedef struct MorseClient
+{
+    int fd;
+    size_t start; // unread bytes are buffer[start, end)
+    size_t end;
+    char buffer[64 * 1024];
+} MorseClient;
+
+typedef struct MorseResponse
+{
+    uint8_t status;
+    char* payload; // NUL-terminated, reused across morse_client_receive calls
+    size_t length;
+    size_t capacity;
+} MorseResponse;
+
+bool morse_client_connect(MorseClient* client, const char* socket_path);
+bool morse_client_send(MorseClient* client, char operation, const char* payload, size_t length);
+bool morse_client_receive(MorseClient* client, MorseResponse* response);
+void morse_client_close(MorseClient* client);
+void morse_response_free(MorseResponse* response);
+
+
+#endif // MORSE_SERVER_H
@@ -0,0 +1,104 @@
+#ifndef MORSE_STATS_H
+#define MORSE_STATS_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+
+/**
+ * Instrumentation counters
+ * ------------------------
+ * Opt-in counters for the codec's hot paths, compiled in with -DMORSE_STATS
+ * (`make stats`). Without it every MORSE_STATS_* hook expands to nothing.
+ *
+ * Usage:
+ *   morse_stats_reset();
+ *   char* text = morse_decode(root, message);
+ *   morse_stats_write_json(stderr);
+ *
+ * Notes:
+ *   Counters are process-wide relaxed atomics, so totals are exact across
+ *   threads but a snapshot taken while other threads run is not a single
+ *   point in time. Allocation counters see the heap calls made by the codec
+ *   and the arena, not allocations a thread-bound arena serves itself.
+ *   Free the strings the codec returns with morse_free() so that frees
+ *   balance mallocs once they are released.
+ *   A call is one message, or one stream through a MorseEncoder/MorseDecoder;
+ *   the parallel codecs count one call per chunk. Divide tree_nodes_visited
+ *   by the calls to get nodes per encode/decode; the table-driven paths only
+ *   visit nodes while building their tables.
+ */
+#define MORSE_STATS_COUNTERS(X) \
+   X(mallocs)            /* malloc and calloc calls */ \
+   X(reallocs) \
+   X(frees) \
+   X(bytes_allocated)    /* bytes requested by mallocs and reallocs */ \
+   X(stack_resizes) \
+   X(stack_peak_depth) \
+   X(queue_resizes) \
+   X(queue_peak_depth) \
+   X(tree_nodes_visited) \
+   X(encode_calls) \
+   X(decode_calls) \
+   X(bytes_in)           /* message bytes read by encode and decode */ \
+   X(bytes_out)          /* bytes they wrote, terminators excluded */
+
+typedef struct MorseStats
+{
+#define MORSE_STATS_FIELD(name) uint64_t name;
+   MORSE_STATS_COUNTERS(MORSE_STATS_FIELD)
+#undef MORSE_STATS_FIELD
+} MorseStats;
+
+#ifdef MORSE_STATS
+#include <stdatomic.h>
+
+typedef struct MorseStatsCounters
+{
+#define MORSE_STATS_FIELD(name) _Atomic uint64_t name;
+   MORSE_STATS_COUNTERS(MORSE_STATS_FIELD)
+#undef MORSE_STATS_FIELD
+} MorseStatsCounters;
+
+extern MorseStatsCounters morse_stats_counters;
+
+static inline void morse_stats_max(_Atomic uint64_t* counter, uint64_t value)
+{
+   uint64_t seen = atomic_load_explicit(counter, memory_order_relaxed);
+   while (value > seen && !atomic_compare_exchange_weak_explicit(counter, &seen, value,
+                                                                 memory_order_relaxed, memory_order_relaxed));
+}
+
+   #define MORSE_STATS_ADD(counter, amount) \
+      atomic_fetch_add_explicit(&morse_stats_counters.counter, (uint64_t)(amount), memory_order_relaxed)
+   #define MORSE_STATS_MAX(counter, value) \
+      morse_stats_max(&morse_stats_counters.counter, (uint64_t)(value))
+
+#else
+   #define MORSE_STATS_ADD(counter, amount) ((void)0)
+   #define MORSE_STATS_MAX(counter, value) ((void)0)
+
+#endif // MORSE_STATS
+
+// Allocation hooks, placed after malloc/realloc and before free
+#define MORSE_STATS_MALLOC(ptr, size) \
+   do { if (ptr) { MORSE_STATS_ADD(mallocs, 1); MORSE_STATS_ADD(bytes_allocated, size); } } while (0)
+#define MORSE_STATS_REALLOC(ptr, size) \
+   do { if (ptr) { MORSE_STATS_ADD(reallocs, 1); MORSE_STATS_ADD(bytes_allocated, size); } } while (0)
+#define MORSE_STATS_FREE(ptr) \
+   do { if (ptr) MORSE_STATS_ADD(frees, 1); } while (0)
+
+// One encode/decode pass over `in` bytes that wrote `out` bytes
+#define MORSE_STATS_CALL(counter, in, out) \
+   do { MORSE_STATS_ADD(counter, 1); MORSE_STATS_ADD(bytes_in, in); MORSE_STATS_ADD(bytes_out, out); } while (0)
+
+// True when the counters were compiled in
+bool morse_stats_enabled(void);
+void morse_stats_snapshot(MorseStats* stats);
+void morse_stats_reset(void);
+// One JSON object with every counter, returns false when writing fails
+bool morse_stats_write_json(FILE* file);
+
+
+#endif // MORSE_STATS_H
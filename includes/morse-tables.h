@@ -0,0 +1,30 @@
+#ifndef MORSE_TABLES_H
+#define MORSE_TABLES_H
+
+#include "morse.h"
+
+
+/**
+ * Default Morse tables
+ * --------------------
+ * The international alphabet and digits as static const data: the encode
+ * and decode tables and a read-only tree for the active backend.
+ *
+ * Usage:
+ *   char* text = morse_decode_with_table(&MORSE_DECODE_TABLE_DEFAULT, message);
+ *   morse_tree_print(morse_tree_default());
+ *
+ * Notes:
+ *   The data is generated at build time by tools/morse-tables-gen.c, which
+ *   runs the library's own tree and table builders, and lives in read-only
+ *   pages shared by every process. Nothing is built at startup.
+ *   The default tree is const: it cannot be passed to morse_tree_insert()
+ *   or morse_tree_delete().
+ */
+extern const MorseEncodeTable MORSE_ENCODE_TABLE_DEFAULT;
+extern const MorseDecodeTable MORSE_DECODE_TABLE_DEFAULT;
+
+const BTreeNode* morse_tree_default(void);
+
+
+#endif // MORSE_TABLES_H
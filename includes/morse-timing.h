@@ -0,0 +1,73 @@
+#ifndef MORSE_TIMING_H
+#define MORSE_TIMING_H
+
+#include "morse.h"
+#include <stdbool.h>
+#include <stddef.h>
+
+
+/**
+ * Timing decoding
+ * ---------------
+ * Decodes a stream of key events, each a key state held for a duration,
+ * as given by a straight key or a tone detector. Durations are in any
+ * unit as long as the stream keeps to it.
+ *
+ * Usage:
+ *   MorseTimingDecoder decoder;
+ *   morse_timing_init(&decoder, &MORSE_DECODE_TABLE_DEFAULT);
+ *   len = morse_timing_feed(&decoder, true, 60.0, output);   // MORSE_TIMING_EVENT_BOUND
+ *   len = morse_timing_feed(&decoder, false, 180.0, output);
+ *   len = morse_timing_finish(&decoder, output);
+ *
+ * Notes:
+ *   Marks are split into dots and dashes, and gaps into element, letter
+ *   and word gaps, at the midpoints between running cluster centres (an
+ *   online k-means with two and three centres). Each duration moves its
+ *   nearest centre a quarter of the way. The dot is kept under 1.5 and
+ *   the dash under 4 element gaps, so a change of speed cannot strand
+ *   one of them. The first mark sets the unit. A much shorter mark or gap
+ *   later restarts the estimate and splits the letter in progress again;
+ *   so does a much slower sender, seen as a mark over 1.5 dashes long or
+ *   as a run of one-element letters whose marks and gaps are all well over
+ *   the unit. Letters written before such a restart stay as written.
+ *   The first long gap is taken as a letter gap until a shorter one shows
+ *   it was a word gap, which keeps Farnsworth spacing apart from words.
+ *   Consecutive events of one state add up, so a key-up may be reported
+ *   in pieces while it lasts; a letter is written by the event that takes
+ *   its gap past the letter threshold, and a word space likewise. Marks
+ *   are classified when their letter ends, packed into a MorseCode and
+ *   looked up in the decode table. The state is a fixed 232 bytes on LP64
+ *   and every event is O(1), so one decoder can run per channel.
+ */
+#define MORSE_TIMING_EVENT_BOUND (MORSE_CODE_MAX_LENGTH + 3) // bytes written by one event or finish
+
+typedef struct MorseTimingDecoder
+{
+    const MorseDecodeTable* table; // shared, must outlive the decoder
+    double dot, dash;       // mark centres, 0 before the first mark
+    double element;         // gap centres; letter and word are 0 until the first long gap
+    double letter;
+    double word;
+    double mark;            // key-down time of the element in progress
+    double gap;             // key-up time since the last element
+    double mark_gap;        // gap before the element in progress
+    size_t symbols;         // marks in the letter in progress
+    double marks[MORSE_CODE_MAX_LENGTH + 1]; // their lengths and the gaps before them,
+    double gaps[MORSE_CODE_MAX_LENGTH + 1];  // classified when the letter ends
+    bool word_open;         // a letter was written since the last word space
+    size_t singles;         // one-element letters written in a row
+    double singles_shortest; // shortest mark or gap among them
+} MorseTimingDecoder;
+
+void morse_timing_init(MorseTimingDecoder* decoder, const MorseDecodeTable* table);
+// The key was down (or up) for `duration`; returns the bytes written. Durations of 0 or less are ignored.
+size_t morse_timing_feed(MorseTimingDecoder* decoder, bool key_down, double duration, char* output);
+// End the message: classify a mark still held and write the letter in progress.
+// The speed estimate is kept for the next message.
+size_t morse_timing_finish(MorseTimingDecoder* decoder, char* output);
+// Estimated character speed for durations of `unit_seconds` each, 0 before the first mark
+double morse_timing_wpm(const MorseTimingDecoder* decoder, double unit_seconds);
+
+
+#endif // MORSE_TIMING_H
@@ -3,41 +3,163 @@
 
 #include "stack.h"
 #include <stddef.h>
+#include <stdint.h>
 #include "queue.h"
+#include "arena.h"
+#include "morse-scan.h"
 
 
+// Longest code (in symbols) the lookup tables can represent
+#define MORSE_CODE_MAX_LENGTH 7
+
+#ifdef MORSE_TREE_FLAT
+// Implicit binary heap: node i has its dot child at 2i+1 and its dash child at 2i+2
+#define MORSE_TREE_FLAT_SIZE ((1u << (MORSE_CODE_MAX_LENGTH + 1)) - 1)
+#define MORSE_TREE_FLAT_CHILD(index, is_dash) (2 * (index) + 1 + (is_dash))
+
+typedef struct BTreeNode
+{
+    char alnum_character[MORSE_TREE_FLAT_SIZE]; // Alphabetic character or \0, one per node
+} BTreeNode;
+#else
 typedef struct BTreeNode
 {
     char alnum_character; // Alphabetic character or \0
     struct BTreeNode* left; // dot (.)
     struct BTreeNode* right; // dash (-)
 } BTreeNode;
+#endif // MORSE_TREE_FLAT
 
 typedef struct Node
 {
-    BTreeNode* node;
+    const BTreeNode* node;
     char* morse_code;
 } Node;
 
+// Packed code: symbol i in bit i (0 dot, 1 dash) below a leading 1 that marks the length,
+// so ".-" packs to 0b110 and the empty code to 1. Codes of up to 7 symbols fit in one byte.
+typedef uint8_t MorseCode;
+#define MORSE_CODE_NONE ((MorseCode)0)
+#define MORSE_CODE_PACK(bits, length) ((MorseCode)((bits) | (1u << (length))))
+
+// Per-byte encode index, built once from the tree
+typedef struct MorseEncodeTable
+{
+    MorseCode code[256]; // MORSE_CODE_NONE if the character has no code
+    uint8_t length[256]; // number of symbols in code
+    uint8_t width[256]; // bytes of output the character produces
+} MorseEncodeTable;
+
+// Packed code decode index, built once from the tree
+typedef struct MorseDecodeTable
+{
+    char alnum_character[256]; // indexed by MorseCode, \0 if no letter
+} MorseDecodeTable;
+
+// How morse_decode_checked treats bytes other than '.', '-', ' ' and '/'
+typedef enum MorseDecodeMode
+{
+    MORSE_DECODE_SKIP, // dropped from their letter, as morse_decode does
+    MORSE_DECODE_LENIENT, // the letter containing them decodes to '?'
+    MORSE_DECODE_STRICT // decoding stops at the first one and returns NULL
+} MorseDecodeMode;
+
+// error_offset value when the message holds no invalid byte
+#define MORSE_DECODE_NO_ERROR SIZE_MAX
+
+// Letter being scanned, carried across blocks and chunks
+typedef struct MorseToken
+{
+    unsigned bits;
+    size_t symbols;
+    bool in_token;
+    bool poisoned; // holds an invalid byte, decodes to '?'
+} MorseToken;
+
+// Incremental decoder: feed a message in chunks of any size, output is written as it goes
+typedef struct MorseDecoder
+{
+    MorseDecodeTable table;
+    MorseDecodeMode mode;
+    MorseClassifyFn classify; // picked for the CPU once, at init
+    MorseToken token;
+    bool last_was_slash; // a '/' ending the message writes no space
+    size_t held_spaces; // trailing spaces withheld until more input arrives
+    size_t consumed; // input bytes fed so far
+    size_t error_offset; // first invalid byte, or MORSE_DECODE_NO_ERROR
+} MorseDecoder;
+
+// Incremental encoder, the counterpart of MorseDecoder
+typedef struct MorseEncoder
+{
+    MorseEncodeTable table;
+    bool held_space; // trailing space withheld until more input arrives
+} MorseEncoder;
+
+// Output capacity one feed/finish call may need
+#define MORSE_DECODER_FEED_BOUND(length) ((length) + 2)
+#define MORSE_DECODER_FINISH_BOUND 3
+#define MORSE_ENCODER_FEED_BOUND(length) ((MORSE_CODE_MAX_LENGTH + 1) * (length) + 1)
+
 #define NODE_STACK_INIT_SIZE 16
 #define NODE_STACK_GROWTH_FACTOR 2
-DEFINE_STACK(Node, size_t, NODE_STACK_INIT_SIZE)
+// Grow through the thread-bound arena unless initialized with another allocator
+DEFINE_STACK_WITH_ALLOCATOR(Node, size_t, NODE_STACK_INIT_SIZE, &ARENA_THREAD_ALLOCATOR)
 
 #define NODE_QUEUE_INIT_SIZE 16
 #define NODE_QUEUE_GROWTH_FACTOR 2
-DEFINE_QUEUE(Node, size_t, NODE_QUEUE_INIT_SIZE)
+DEFINE_QUEUE_WITH_ALLOCATOR(Node, size_t, NODE_QUEUE_INIT_SIZE, &ARENA_THREAD_ALLOCATOR)
 
 
 BTreeNode* morse_tree_init(void);
 void morse_tree_delete(BTreeNode* root);
 void morse_tree_insert(BTreeNode* root, const char* morse_code, char alnum_character);
-void morse_tree_print(BTreeNode* root);
+void morse_tree_print(const BTreeNode* root);
 bool is_valid_morse_message(const char* message);
 char* reverse_string(const char* string);
-char decode_letter(BTreeNode* root, const char* morse_code);
-char* encode_letter(BTreeNode* root, const char alnum_character);
-char* morse_decode(BTreeNode* root, const char* morse_message);
-char* morse_encode(BTreeNode* root, const char* text_message);
+size_t reverse_string_into(const char* string, char* output, size_t capacity);
+char decode_letter(const BTreeNode* root, const char* morse_code);
+char decode_letter_n(const BTreeNode* root, const char* morse_code, size_t length);
+char* encode_letter(const BTreeNode* root, const char alnum_character);
+size_t encode_letter_into(const BTreeNode* root, const char alnum_character, char* output, size_t capacity);
+char* morse_decode(const BTreeNode* root, const char* morse_message);
+char* morse_decode_reference(const BTreeNode* root, const char* morse_message);
+char* morse_encode(const BTreeNode* root, const char* text_message);
+char* morse_encode_n(const BTreeNode* root, const char* text_message, size_t length);
+char* morse_encode_n_with_table(const MorseEncodeTable* table, const char* text_message, size_t length);
+void morse_encode_table_build(const BTreeNode* root, MorseEncodeTable* table);
+char* morse_encode_with_table(const MorseEncodeTable* table, const char* text_message);
+size_t morse_encoded_length(const MorseEncodeTable* table, const char* text_message, size_t length);
+size_t morse_encode_span(const MorseEncodeTable* table, const char* text_message, size_t length, char* output);
+size_t morse_encode_chars(const MorseEncodeTable* table, const char* text_message, size_t length, char* output);
+size_t morse_encode_size(const BTreeNode* root, const char* text_message, size_t length);
+size_t morse_encode_size_with_table(const MorseEncodeTable* table, const char* text_message, size_t length);
+size_t morse_encode_into(const BTreeNode* root, const char* text_message, size_t length, char* output, size_t capacity);
+size_t morse_encode_into_with_table(const MorseEncodeTable* table, const char* text_message, size_t length,
+                                    char* output, size_t capacity);
+void morse_decode_table_build(const BTreeNode* root, MorseDecodeTable* table);
+char* morse_decode_with_table(const MorseDecodeTable* table, const char* morse_message);
+size_t morse_decode_size(const char* morse_message, size_t message_len);
+size_t morse_decode_chars(const MorseDecodeTable* table, const char* morse_message, size_t length,
+                          MorseDecodeMode mode, char* output, size_t* invalid_offset);
+size_t morse_decode_into(const BTreeNode* root, const char* morse_message, size_t message_len,
+                         char* output, size_t capacity);
+size_t morse_decode_into_with_table(const MorseDecodeTable* table, const char* morse_message, size_t message_len,
+                                    char* output, size_t capacity);
+char* morse_decode_checked(const BTreeNode* root, const char* morse_message, size_t message_len,
+                           MorseDecodeMode mode, size_t* error_offset);
+char* morse_decode_checked_with_table(const MorseDecodeTable* table, const char* morse_message, size_t message_len,
+                                      MorseDecodeMode mode, size_t* error_offset);
+void morse_decoder_init(MorseDecoder* decoder, const BTreeNode* root, MorseDecodeMode mode);
+void morse_decoder_init_with_table(MorseDecoder* decoder, const MorseDecodeTable* table, MorseDecodeMode mode);
+bool morse_decoder_feed(MorseDecoder* decoder, const char* input, size_t length, char* output, size_t* written);
+size_t morse_decoder_finish(MorseDecoder* decoder, char* output);
+void morse_encoder_init(MorseEncoder* encoder, const BTreeNode* root);
+void morse_encoder_init_with_table(MorseEncoder* encoder, const MorseEncodeTable* table);
+size_t morse_encoder_feed(MorseEncoder* encoder, const char* input, size_t length, char* output);
+void morse_encoder_finish(MorseEncoder* encoder);
+// Free a string returned by the codec, counted as a free in a stats build
+void morse_free(void* ptr);
 
 
 #endif // MORSE_H
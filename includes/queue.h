@@ -6,6 +6,8 @@
 #include "static-assert.h"
 #include "swap.h"
 #include "memory-copy.h"
+#include "morse-stats.h"
+#include "allocator.h"
 
 
 /**
@@ -48,6 +50,66 @@ static inline void type##_queue_init(type##_queue_s *const restrict queue) \
    queue->len = 0; \
    queue->size = init_size; \
 } \
+DEFINE_QUEUE_FUNCTIONS(type, len_type)
+
+
+/**
+ * DEFINE_QUEUE_WITH_ALLOCATOR macro
+ * ------------
+ * Like DEFINE_QUEUE(...), but each queue carries a pointer to the Allocator
+ * (includes/allocator.h) its heap buffer comes from, so one instance can grow
+ * in a scratch arena while another uses malloc.
+ *
+ * Parameters:
+ *   type              - Type of elements stored in the queue
+ *   len_type          - Integer type used for length/size
+ *   init_size         - Number of elements to store inline before heap allocation
+ *   default_allocator - const Allocator* taken by type##_queue_init
+ *
+ * Output:
+ *   Declaration of queue for type, with type##_queue_init_with_allocator
+ *
+ * Notes:
+ *    Use only in a header (.h) file
+ *    Use in combination with GENERATE_QUEUE_WITH_ALLOCATOR(...), Ensure macro arguments match
+ *    Costs a pointer per queue and an indirect call per allocation; plain
+ *    DEFINE_QUEUE(...) with fixed functions stays the zero-overhead default.
+ */
+#define DEFINE_QUEUE_WITH_ALLOCATOR(type, len_type, init_size, default_allocator) \
+   static_assert(init_size > 1, "Warning: init_size too small"); \
+   static_assert(init_size < 256, "Warning: init_size too big"); \
+   static_assert(init_size != 0 && (init_size & (init_size - 1)) == 0, "Warning: init_size must be a power of 2"); /* resize optimization */ \
+   assert_istype(type); \
+   assert_istype(len_type); \
+\
+typedef struct \
+{ \
+   type inline_buffer[init_size]; \
+   type *values; \
+   len_type head; \
+   len_type len; \
+   len_type size; \
+   const Allocator *allocator; \
+} type##_queue_s; \
+\
+static inline void type##_queue_init_with_allocator(type##_queue_s *const restrict queue, const Allocator *const allocator) \
+{ \
+   assert(allocator); \
+   queue->allocator = allocator; \
+   queue->values = queue->inline_buffer; \
+   queue->head = 0; \
+   queue->len = 0; \
+   queue->size = init_size; \
+} \
+static inline void type##_queue_init(type##_queue_s *const restrict queue) \
+{ \
+   type##_queue_init_with_allocator(queue, default_allocator); \
+} \
+DEFINE_QUEUE_FUNCTIONS(type, len_type)
+
+
+/* Shared by DEFINE_QUEUE and DEFINE_QUEUE_WITH_ALLOCATOR: the inline queries and the prototypes */
+#define DEFINE_QUEUE_FUNCTIONS(type, len_type) \
 static inline bool type##_queue_empty(const type##_queue_s *const restrict queue) \
 { \
    assert(queue); \
@@ -59,10 +121,14 @@ static inline bool type##_queue_full(const type##_queue_s *const restrict queue)
    return queue->len == queue->size; \
 } \
 bool type##_queue_resize(type##_queue_s *const restrict); \
+bool type##_queue_reserve(type##_queue_s *const restrict, const len_type); \
+bool type##_queue_shrink_to_fit(type##_queue_s *const restrict); \
 void type##_queue_clear(type##_queue_s *const restrict); \
 void type##_queue_delete(type##_queue_s *const restrict); \
 bool type##_queue_enque(type##_queue_s *const restrict, const type); \
+bool type##_queue_enque_n(type##_queue_s *const restrict, const type *const restrict, const len_type); \
 bool type##_queue_deque(type##_queue_s *const restrict); \
+len_type type##_queue_deque_n(type##_queue_s *const restrict, type *const restrict, const len_type); \
 type type##_queue_peek(const type##_queue_s *const restrict); \
 void type##_queue_reverse(type##_queue_s *const restrict);
 
@@ -85,6 +151,11 @@ void type##_queue_reverse(type##_queue_s *const restrict);
  * Notes:
  *    Use only in a source (.c) file
  *    Use in combination with DEFINE_QUEUE(...), Ensure macro arguments match
+ *    Capacities stay powers of 2 on the init_size * growth_factor^k sequence:
+ *    reserve jumps straight to the first one that fits, shrink_to_fit drops
+ *    to the smallest one that still holds the elements, or back to the
+ *    inline buffer. enque_n/deque_n move a block with at most two
+ *    MEMORY_COPYs, one on each side of the wrap.
  */
 #define GENERATE_QUEUE(type, len_type, init_size, growth_factor, validate_value_fn, alloc_fn, realloc_fn, free_fn) \
    static_assert(init_size > 1, "Warning: init_size too small"); \
@@ -100,52 +171,153 @@ void type##_queue_reverse(type##_queue_s *const restrict);
    assert_type(realloc_fn, void* (void*, size_t)); \
    assert_type(free_fn, void (void*)); \
 \
-bool type##_queue_resize(type##_queue_s *const restrict queue) \
+static inline void *type##_queue_mem_alloc(const type##_queue_s *const restrict queue, const size_t size) \
 { \
-   assert(queue); \
-   void *tmp; \
+   (void)queue; \
+   return alloc_fn(size); \
+} \
+static inline void *type##_queue_mem_realloc(const type##_queue_s *const restrict queue, void *const ptr, const size_t size) \
+{ \
+   (void)queue; \
+   return realloc_fn(ptr, size); \
+} \
+static inline void type##_queue_mem_free(const type##_queue_s *const restrict queue, void *const ptr) \
+{ \
+   (void)queue; \
+   free_fn(ptr); \
+} \
+GENERATE_QUEUE_FUNCTIONS(type, len_type, init_size, growth_factor, validate_value_fn)
+
+
+/**
+ * GENERATE_QUEUE_WITH_ALLOCATOR macro
+ * ----------------
+ * Implements the queue functions for a type declared with
+ * DEFINE_QUEUE_WITH_ALLOCATOR(...), allocating through each queue's allocator.
+ *
+ * Parameters:
+ *   As GENERATE_QUEUE(...), without alloc_fn, realloc_fn and free_fn
+ *
+ * Output:
+ *   Implementation of queue for type
+ *
+ * Notes:
+ *    Use only in a source (.c) file
+ *    Use in combination with DEFINE_QUEUE_WITH_ALLOCATOR(...), Ensure macro arguments match
+ */
+#define GENERATE_QUEUE_WITH_ALLOCATOR(type, len_type, init_size, growth_factor, validate_value_fn) \
+   static_assert(init_size > 1, "Warning: init_size too small"); \
+   static_assert(init_size < 256, "Warning: init_size too big"); \
+   static_assert(init_size != 0 && (init_size & (init_size - 1)) == 0, "Warning: init_size must be a power of 2"); /* resize optimization */ \
+   static_assert(growth_factor > 1, "Warning: growth_factor too small"); \
+   static_assert(growth_factor < 32,  "Warning: growth_factor too big"); \
+   static_assert(growth_factor != 0 && (growth_factor & (growth_factor - 1)) == 0, "Warning: growth_factor must be a power of 2"); /* resize optimization */ \
+   assert_istype(type); \
+   assert_istype(len_type); \
+   assert_type(validate_value_fn((type){0}), bool); \
 \
-   if (queue->size > (len_type)(-1) / growth_factor) /* Prevent overflow */ \
-      return false; \
-   len_type new_size = queue->size * growth_factor; \
+static inline void *type##_queue_mem_alloc(const type##_queue_s *const restrict queue, const size_t size) \
+{ \
+   return queue->allocator->alloc(queue->allocator->context, size); \
+} \
+static inline void *type##_queue_mem_realloc(const type##_queue_s *const restrict queue, void *const ptr, const size_t size) \
+{ \
+   return queue->allocator->realloc(queue->allocator->context, ptr, size); \
+} \
+static inline void type##_queue_mem_free(const type##_queue_s *const restrict queue, void *const ptr) \
+{ \
+   queue->allocator->free(queue->allocator->context, ptr); \
+} \
+GENERATE_QUEUE_FUNCTIONS(type, len_type, init_size, growth_factor, validate_value_fn)
+
+
+/* Shared by GENERATE_QUEUE and GENERATE_QUEUE_WITH_ALLOCATOR, which define type##_queue_mem_* */
+#define GENERATE_QUEUE_FUNCTIONS(type, len_type, init_size, growth_factor, validate_value_fn) \
+/* Copy the elements, unwrapped, to the start of `values` */ \
+static void type##_queue_unwrap_into(const type##_queue_s *const restrict queue, type *const restrict values) \
+{ \
+   len_type first_chunk = queue->size - queue->head; \
+   if (first_chunk > queue->len) \
+      first_chunk = queue->len; \
+   MEMORY_COPY(values, &queue->values[queue->head], sizeof(type) * first_chunk); \
+   MEMORY_COPY(values + first_chunk, queue->values, sizeof(type) * (queue->len - first_chunk)); \
+} \
+\
+/* Move the elements to a heap buffer of new_size >= len */ \
+static bool type##_queue_reallocate(type##_queue_s *const restrict queue, const len_type new_size) \
+{ \
+   void *tmp; \
 \
    const bool in_heap = (queue->values != queue->inline_buffer); /* underlying array is allocated in heap */ \
-   const bool not_wrapped = (queue->head + queue->len <= queue->size); /* Elements not wrapped around the underlying array */ \
+   const bool fits_in_place = (queue->head + queue->len <= (new_size < queue->size ? new_size : queue->size)); /* Elements not wrapped around either array */ \
 \
-   if (not_wrapped && in_heap) \
+   if (fits_in_place && in_heap) \
    { \
-      tmp = realloc_fn(queue->values, sizeof(type) * new_size); \
+      tmp = type##_queue_mem_realloc(queue, queue->values, sizeof(type) * new_size); \
       if (!tmp)  \
          return false; \
    } \
    else \
    { \
-      tmp = alloc_fn(sizeof(type) * new_size); \
+      tmp = type##_queue_mem_alloc(queue, sizeof(type) * new_size); \
       if (!tmp) \
          return false; \
 \
-      if (not_wrapped) \
-      { \
-         MEMORY_COPY(tmp, queue->values, sizeof(type) * queue->len); \
-      } \
-      else \
-      { \
-         len_type first_chunk = queue->size - queue->head; \
-         MEMORY_COPY(tmp, &queue->values[queue->head], sizeof(type) * first_chunk); \
-         MEMORY_COPY((type*)tmp + first_chunk, queue->values, sizeof(type) * queue->head); \
-      } \
-\
+      type##_queue_unwrap_into(queue, (type*)tmp); \
       if (in_heap) \
-         free_fn(queue->values); \
+         type##_queue_mem_free(queue, queue->values); \
+      queue->head = 0; \
    } \
 \
    queue->size = new_size; \
    queue->values = (type*)tmp; \
-   if (!not_wrapped) \
-      queue->head = 0; \
+   MORSE_STATS_ADD(queue_resizes, 1); \
    return true; \
 } \
 \
+bool type##_queue_resize(type##_queue_s *const restrict queue) \
+{ \
+   assert(queue); \
+   if (queue->size > (len_type)(-1) / growth_factor) /* Prevent overflow */ \
+      return false; \
+   return type##_queue_reallocate(queue, queue->size * growth_factor); \
+} \
+\
+bool type##_queue_reserve(type##_queue_s *const restrict queue, const len_type capacity) \
+{ \
+   assert(queue); \
+   len_type new_size = queue->size; \
+   while (new_size < capacity) \
+   { \
+      if (new_size > (len_type)(-1) / growth_factor) /* Prevent overflow */ \
+         return false; \
+      new_size *= growth_factor; \
+   } \
+   return new_size == queue->size || type##_queue_reallocate(queue, new_size); \
+} \
+\
+bool type##_queue_shrink_to_fit(type##_queue_s *const restrict queue) \
+{ \
+   assert(queue); \
+   if (queue->values == queue->inline_buffer) \
+      return true; \
+\
+   if (queue->len <= init_size) \
+   { \
+      type##_queue_unwrap_into(queue, queue->inline_buffer); \
+      type##_queue_mem_free(queue, queue->values); \
+      queue->values = queue->inline_buffer; \
+      queue->head = 0; \
+      queue->size = init_size; \
+      return true; \
+   } \
+\
+   len_type new_size = init_size; \
+   while (new_size < queue->len) \
+      new_size *= growth_factor; \
+   return new_size == queue->size || type##_queue_reallocate(queue, new_size); \
+} \
+\
 void type##_queue_clear(type##_queue_s *const restrict queue) \
 { \
    assert(queue); \
@@ -159,7 +331,7 @@ void type##_queue_delete(type##_queue_s *const restrict queue) \
    type##_queue_clear(queue); \
    if (queue->values != queue->inline_buffer) \
    { \
-      free_fn(queue->values); \
+      type##_queue_mem_free(queue, queue->values); \
       queue->values = queue->inline_buffer; \
       queue->size = init_size; \
    } \
@@ -174,6 +346,27 @@ bool type##_queue_enque(type##_queue_s *const restrict queue, const type value)
    /* queue->values[(queue->head + queue->len) % queue->size] = value; */ \
    queue->values[(queue->head + queue->len) & (queue->size - 1)] = value; \
    queue->len++; \
+   MORSE_STATS_MAX(queue_peak_depth, queue->len); \
+   return true; \
+} \
+\
+bool type##_queue_enque_n(type##_queue_s *const restrict queue, const type *const restrict values, const len_type count) \
+{ \
+   assert(queue); \
+   assert(values || count == 0); \
+   for (len_type i = 0; i < count; i++) \
+      assert(validate_value_fn(values[i])); \
+   if (count > (len_type)(-1) - queue->len) /* Prevent overflow */ \
+      return false; \
+   if (queue->len + count > queue->size && !type##_queue_reserve(queue, queue->len + count)) \
+      return false; \
+\
+   len_type tail = (queue->head + queue->len) & (queue->size - 1); \
+   len_type first_chunk = queue->size - tail < count ? queue->size - tail : count; \
+   MEMORY_COPY(&queue->values[tail], values, sizeof(type) * first_chunk); \
+   MEMORY_COPY(queue->values, values + first_chunk, sizeof(type) * (count - first_chunk)); \
+   queue->len += count; \
+   MORSE_STATS_MAX(queue_peak_depth, queue->len); \
    return true; \
 } \
 \
@@ -188,6 +381,21 @@ bool type##_queue_deque(type##_queue_s *const restrict queue) \
    return true; \
 } \
 \
+len_type type##_queue_deque_n(type##_queue_s *const restrict queue, type *const restrict values, const len_type count) \
+{ \
+   assert(queue); \
+   len_type taken = count < queue->len ? count : queue->len; \
+   if (values) /* NULL only drops them */ \
+   { \
+      len_type first_chunk = queue->size - queue->head < taken ? queue->size - queue->head : taken; \
+      MEMORY_COPY(values, &queue->values[queue->head], sizeof(type) * first_chunk); \
+      MEMORY_COPY(values + first_chunk, queue->values, sizeof(type) * (taken - first_chunk)); \
+   } \
+   queue->head = (queue->head + taken) & (queue->size - 1); \
+   queue->len -= taken; \
+   return taken; \
+} \
+\
 type type##_queue_peek(const type##_queue_s *const restrict queue) \
 { \
    assert(queue); \
@@ -263,9 +471,14 @@ void type##_queue_reverse(type##_queue_s *const restrict queue) \
  * 
  * Usage:
  *   queue(int) q = queue_create(int);    // Create a new int queue
+ *   queue_init_with_allocator(int, &q, &allocator); // ... growing through `allocator`
  *   queue_insert_tail(int, &q, 42);      // Insert a value
+ *   queue_enque_n(int, &q, values, n);   // Insert n values in order
  *   int top = queue_peek_head(int, &q);  // Peek at the top value
  *   queue_remove_head(int, &q);          // Pop the top value
+ *   queue_deque_n(int, &q, values, n);   // Take up to n values, returns how many
+ *   queue_reserve(int, &q, 1000);        // Room for 1000 values up front
+ *   queue_shrink_to_fit(int, &q);        // Give back unused heap memory
  *   queue_clear(int, &q);                // Reset the queue
  *   queue_delete(int, &q);               // Free any heap memory
  */
@@ -274,11 +487,26 @@ void type##_queue_reverse(type##_queue_s *const restrict queue) \
       type##_queue_init((queue)) \
    )
 
+#define queue_init_with_allocator(type, queue, allocator) \
+   typecheck_queue_ptr(queue, type, \
+      type##_queue_init_with_allocator((queue), (allocator)) \
+   )
+
 #define queue_resize(type, queue) \
    typecheck_queue_ptr(queue, type, \
       type##_queue_resize((queue)) \
    )
 
+#define queue_reserve(type, queue, capacity) \
+   typecheck_queue_ptr(queue, type, \
+      type##_queue_reserve((queue), (capacity)) \
+   )
+
+#define queue_shrink_to_fit(type, queue) \
+   typecheck_queue_ptr(queue, type, \
+      type##_queue_shrink_to_fit((queue)) \
+   )
+
 #define queue_clear(type, queue) \
    typecheck_queue_ptr(queue, type, \
       type##_queue_clear((queue)) \
@@ -304,11 +532,21 @@ void type##_queue_reverse(type##_queue_s *const restrict queue) \
       type##_queue_enque((queue), (value)) \
    )
 
+#define queue_enque_n(type, queue, values, count) \
+   typecheck_queue_ptr(queue, type, \
+      type##_queue_enque_n((queue), (values), (count)) \
+   )
+
 #define queue_deque(type, queue) \
    typecheck_queue_ptr(queue, type, \
       type##_queue_deque((queue)) \
    )
 
+#define queue_deque_n(type, queue, values, count) \
+   typecheck_queue_ptr(queue, type, \
+      type##_queue_deque_n((queue), (values), (count)) \
+   )
+
 #define queue_peek(type, queue) \
    typecheck_queue_ptr(queue, type, \
       type##_queue_peek((queue)) \
@@ -0,0 +1,268 @@
+#ifndef __SPSC_QUEUE_H
+#define __SPSC_QUEUE_H
+
+#include <stdbool.h>
+#include <stdatomic.h>
+#include <assert.h>
+#include "static-assert.h"
+#include "memory-copy.h"
+
+
+/**
+ * SPSC_CACHE_LINE
+ * ---------------
+ * Alignment that keeps the producer's and the consumer's fields on separate
+ * cache lines, so neither invalidates the other's line on every element.
+ * Define it as 128 for CPUs that prefetch lines in adjacent pairs.
+ */
+#ifndef SPSC_CACHE_LINE
+   #define SPSC_CACHE_LINE 64
+#endif
+
+
+/**
+ * DEFINE_SPSC_QUEUE macro
+ * ------------
+ * Defines a fixed-capacity, lock-free, single-producer/single-consumer queue
+ * type with an inline ring buffer of `capacity` elements.
+ *
+ * Parameters:
+ *   type      - Type of elements stored in the queue
+ *   len_type  - Unsigned integer type used for positions and counts
+ *   capacity  - Number of elements the queue holds
+ *
+ * Output:
+ *   Declaration of the SPSC queue for type
+ *
+ * Notes:
+ *    Use only in a header (.h) file
+ *    Use in combination with GENERATE_SPSC_QUEUE(...), Ensure macro arguments match
+ *    One thread may enque and one other thread may deque at the same time; any
+ *    other sharing needs outside locking. init must run before either thread
+ *    uses the queue. len may be called from either side and is only exact
+ *    while the other side is idle.
+ *    The struct is aligned to SPSC_CACHE_LINE: allocate it statically, on the
+ *    stack or with aligned_alloc.
+ */
+#define DEFINE_SPSC_QUEUE(type, len_type, capacity) \
+   static_assert(capacity > 1, "Warning: capacity too small"); \
+   static_assert(capacity <= (1ul << 24), "Warning: capacity too big"); \
+   static_assert(capacity != 0 && (capacity & (capacity - 1)) == 0, "Warning: capacity must be a power of 2"); /* masking */ \
+   static_assert((len_type)(-1) > 0, "Warning: len_type must be unsigned"); /* positions wrap */ \
+   static_assert(capacity <= ((len_type)(-1) >> 1) + 1, "Warning: capacity too big for len_type"); /* tail - head reaches capacity */ \
+   assert_istype(type); \
+   assert_istype(len_type); \
+\
+typedef struct \
+{ \
+   _Alignas(SPSC_CACHE_LINE) _Atomic len_type tail; /* next slot to fill, stored by the producer */ \
+   len_type cached_head;                           /* producer's last view of head */ \
+   _Alignas(SPSC_CACHE_LINE) _Atomic len_type head; /* next slot to read, stored by the consumer */ \
+   len_type cached_tail;                           /* consumer's last view of tail */ \
+   _Alignas(SPSC_CACHE_LINE) type values[capacity]; \
+} type##_spsc_queue_s; \
+\
+static inline void type##_spsc_queue_init(type##_spsc_queue_s *const restrict queue) \
+{ \
+   atomic_init(&queue->tail, 0); \
+   atomic_init(&queue->head, 0); \
+   queue->cached_head = 0; \
+   queue->cached_tail = 0; \
+} \
+bool type##_spsc_queue_enque(type##_spsc_queue_s *const restrict, const type); \
+bool type##_spsc_queue_deque(type##_spsc_queue_s *const restrict, type *const restrict); \
+len_type type##_spsc_queue_enque_n(type##_spsc_queue_s *const restrict, const type *const restrict, len_type); \
+len_type type##_spsc_queue_deque_n(type##_spsc_queue_s *const restrict, type *const restrict, len_type); \
+len_type type##_spsc_queue_len(type##_spsc_queue_s *const restrict);
+
+
+/**
+ * GENERATE_SPSC_QUEUE macro
+ * ----------------
+ * Implements the SPSC queue functions for a type.
+ *
+ * Parameters:
+ *   type           - Element type
+ *   len_type       - Unsigned integer type for positions & counts
+ *   capacity       - Ring buffer size
+ *   validate_value - Function to validate a value (asserted in debug)
+ *
+ * Output:
+ *   Implementation of the SPSC queue for type
+ *
+ * Notes:
+ *    Use only in a source (.c) file
+ *    Use in combination with DEFINE_SPSC_QUEUE(...), Ensure macro arguments match
+ *    head and tail run freely and are masked on access, so a full queue is
+ *    tail - head == capacity. Each side publishes its position with a release
+ *    store and reads the other's with an acquire load, and only when its cached
+ *    copy says the queue is full (or empty), so a burst costs one shared load.
+ *    The batch calls move as many elements as fit, in at most two copies, and
+ *    publish them with one store.
+ */
+#define GENERATE_SPSC_QUEUE(type, len_type, capacity, validate_value_fn) \
+   static_assert(capacity > 1, "Warning: capacity too small"); \
+   static_assert(capacity <= (1ul << 24), "Warning: capacity too big"); \
+   static_assert(capacity != 0 && (capacity & (capacity - 1)) == 0, "Warning: capacity must be a power of 2"); /* masking */ \
+   static_assert((len_type)(-1) > 0, "Warning: len_type must be unsigned"); /* positions wrap */ \
+   static_assert(capacity <= ((len_type)(-1) >> 1) + 1, "Warning: capacity too big for len_type"); /* tail - head reaches capacity */ \
+   assert_istype(type); \
+   assert_istype(len_type); \
+   assert_type(validate_value_fn((type){0}), bool); \
+\
+bool type##_spsc_queue_enque(type##_spsc_queue_s *const restrict queue, const type value) \
+{ \
+   assert(queue); \
+   assert(validate_value_fn(value)); \
+   len_type tail = atomic_load_explicit(&queue->tail, memory_order_relaxed); \
+   if ((len_type)(tail - queue->cached_head) == capacity) \
+   { \
+      queue->cached_head = atomic_load_explicit(&queue->head, memory_order_acquire); \
+      if ((len_type)(tail - queue->cached_head) == capacity) \
+         return false; \
+   } \
+   queue->values[tail & (capacity - 1)] = value; \
+   atomic_store_explicit(&queue->tail, (len_type)(tail + 1), memory_order_release); \
+   return true; \
+} \
+\
+bool type##_spsc_queue_deque(type##_spsc_queue_s *const restrict queue, type *const restrict value) \
+{ \
+   assert(queue); \
+   assert(value); \
+   len_type head = atomic_load_explicit(&queue->head, memory_order_relaxed); \
+   if (head == queue->cached_tail) \
+   { \
+      queue->cached_tail = atomic_load_explicit(&queue->tail, memory_order_acquire); \
+      if (head == queue->cached_tail) \
+         return false; \
+   } \
+   *value = queue->values[head & (capacity - 1)]; \
+   atomic_store_explicit(&queue->head, (len_type)(head + 1), memory_order_release); \
+   return true; \
+} \
+\
+len_type type##_spsc_queue_enque_n(type##_spsc_queue_s *const restrict queue, const type *const restrict values, len_type count) \
+{ \
+   assert(queue); \
+   assert(values || count == 0); \
+   len_type tail = atomic_load_explicit(&queue->tail, memory_order_relaxed); \
+   len_type space = capacity - (len_type)(tail - queue->cached_head); \
+   if (space < count) \
+   { \
+      queue->cached_head = atomic_load_explicit(&queue->head, memory_order_acquire); \
+      space = capacity - (len_type)(tail - queue->cached_head); \
+   } \
+   if (count > space) \
+      count = space; \
+   if (count == 0) \
+      return 0; \
+\
+   len_type start = tail & (capacity - 1); \
+   len_type first_chunk = capacity - start < count ? capacity - start : count; \
+   MEMORY_COPY(&queue->values[start], values, sizeof(type) * first_chunk); \
+   MEMORY_COPY(queue->values, values + first_chunk, sizeof(type) * (count - first_chunk)); \
+   atomic_store_explicit(&queue->tail, (len_type)(tail + count), memory_order_release); \
+   return count; \
+} \
+\
+len_type type##_spsc_queue_deque_n(type##_spsc_queue_s *const restrict queue, type *const restrict values, len_type count) \
+{ \
+   assert(queue); \
+   assert(values || count == 0); \
+   len_type head = atomic_load_explicit(&queue->head, memory_order_relaxed); \
+   len_type available = (len_type)(queue->cached_tail - head); \
+   if (available < count) \
+   { \
+      queue->cached_tail = atomic_load_explicit(&queue->tail, memory_order_acquire); \
+      available = (len_type)(queue->cached_tail - head); \
+   } \
+   if (count > available) \
+      count = available; \
+   if (count == 0) \
+      return 0; \
+\
+   len_type start = head & (capacity - 1); \
+   len_type first_chunk = capacity - start < count ? capacity - start : count; \
+   MEMORY_COPY(values, &queue->values[start], sizeof(type) * first_chunk); \
+   MEMORY_COPY(values + first_chunk, queue->values, sizeof(type) * (count - first_chunk)); \
+   atomic_store_explicit(&queue->head, (len_type)(head + count), memory_order_release); \
+   return count; \
+} \
+\
+len_type type##_spsc_queue_len(type##_spsc_queue_s *const restrict queue) \
+{ \
+   assert(queue); \
+   /* head first: read the other way round, a consumer racing ahead could make tail - head negative */ \
+   len_type head = atomic_load_explicit(&queue->head, memory_order_acquire); \
+   len_type tail = atomic_load_explicit(&queue->tail, memory_order_acquire); \
+   return (len_type)(tail - head); \
+}
+
+
+/**
+ * spsc_queue(type) macro
+ * -----------------
+ * Declares an SPSC queue variable of the given type.
+ *
+ * Usage:
+ *   static spsc_queue(int) pipe;
+ */
+#define spsc_queue(type) \
+   type##_spsc_queue_s
+
+
+/**
+ * typecheck_spsc_queue_ptr macro
+ * --------------------------
+ * Compile-time validation that 'var' is a pointer to an SPSC queue of 'type'.
+ * See typecheck_queue_ptr.
+ */
+#define typecheck_spsc_queue_ptr(var, type, expr) \
+   typecheck_ptr(var, type##_spsc_queue_s, expr)
+
+
+/**
+ * SPSC queue function macros
+ * --------------------
+ * Type-generic wrappers for the SPSC queue operations.
+ *
+ * Usage:
+ *   spsc_queue_init(int, &pipe);                   // Before either thread starts
+ *   spsc_queue_enque(int, &pipe, 42);              // Producer: false when full
+ *   spsc_queue_enque_n(int, &pipe, values, n);     // Producer: returns how many fit
+ *   spsc_queue_deque(int, &pipe, &value);          // Consumer: false when empty
+ *   spsc_queue_deque_n(int, &pipe, values, n);     // Consumer: returns how many were taken
+ */
+#define spsc_queue_init(type, queue) \
+   typecheck_spsc_queue_ptr(queue, type, \
+      type##_spsc_queue_init((queue)) \
+   )
+
+#define spsc_queue_enque(type, queue, value) \
+   typecheck_spsc_queue_ptr(queue, type, \
+      type##_spsc_queue_enque((queue), (value)) \
+   )
+
+#define spsc_queue_deque(type, queue, value) \
+   typecheck_spsc_queue_ptr(queue, type, \
+      type##_spsc_queue_deque((queue), (value)) \
+   )
+
+#define spsc_queue_enque_n(type, queue, values, count) \
+   typecheck_spsc_queue_ptr(queue, type, \
+      type##_spsc_queue_enque_n((queue), (values), (count)) \
+   )
+
+#define spsc_queue_deque_n(type, queue, values, count) \
+   typecheck_spsc_queue_ptr(queue, type, \
+      type##_spsc_queue_deque_n((queue), (values), (count)) \
+   )
+
+#define spsc_queue_len(type, queue) \
+   typecheck_spsc_queue_ptr(queue, type, \
+      type##_spsc_queue_len((queue)) \
+   )
+
+
+#endif /* __SPSC_QUEUE_H */
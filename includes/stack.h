@@ -6,6 +6,8 @@
 #include "static-assert.h"
 #include "swap.h"
 #include "memory-copy.h"
+#include "morse-stats.h"
+#include "allocator.h"
 
 
 /**
@@ -46,6 +48,64 @@ static inline void type##_stack_init(type##_stack_s *const restrict stack) \
    stack->len = 0; \
    stack->size = init_size; \
 } \
+DEFINE_STACK_FUNCTIONS(type, len_type)
+
+
+/**
+ * DEFINE_STACK_WITH_ALLOCATOR macro
+ * ------------
+ * Like DEFINE_STACK(...), but each stack carries a pointer to the Allocator
+ * (includes/allocator.h) its heap buffer comes from, so one instance can grow
+ * in a scratch arena while another uses malloc.
+ *
+ * Parameters:
+ *   type              - Type of elements stored in the stack
+ *   len_type          - Integer type used for length/size
+ *   init_size         - Number of elements to store inline before heap allocation
+ *   default_allocator - const Allocator* taken by type##_stack_init
+ *
+ * Output:
+ *   Declaration of stack for type, with type##_stack_init_with_allocator
+ *
+ * Notes:
+ *    Use only in a header (.h) file
+ *    Use in combination with GENERATE_STACK_WITH_ALLOCATOR(...), Ensure macro arguments match
+ *    Costs a pointer per stack and an indirect call per allocation; plain
+ *    DEFINE_STACK(...) with fixed functions stays the zero-overhead default.
+ */
+#define DEFINE_STACK_WITH_ALLOCATOR(type, len_type, init_size, default_allocator) \
+   static_assert(init_size > 1, "Warning: init_size too small"); \
+   static_assert(init_size < 256, "Warning: init_size too big"); \
+   static_assert(init_size != 0 && (init_size & (init_size - 1)) == 0, "Warning: init_size must be a power of 2"); /* resize optimization */ \
+   assert_istype(type); \
+   assert_istype(len_type); \
+\
+typedef struct \
+{ \
+   type inline_buffer[init_size]; \
+   type *values; \
+   len_type len; \
+   len_type size; \
+   const Allocator *allocator; \
+} type##_stack_s; \
+\
+static inline void type##_stack_init_with_allocator(type##_stack_s *const restrict stack, const Allocator *const allocator) \
+{ \
+   assert(allocator); \
+   stack->allocator = allocator; \
+   stack->values = stack->inline_buffer; \
+   stack->len = 0; \
+   stack->size = init_size; \
+} \
+static inline void type##_stack_init(type##_stack_s *const restrict stack) \
+{ \
+   type##_stack_init_with_allocator(stack, default_allocator); \
+} \
+DEFINE_STACK_FUNCTIONS(type, len_type)
+
+
+/* Shared by DEFINE_STACK and DEFINE_STACK_WITH_ALLOCATOR: the inline queries and the prototypes */
+#define DEFINE_STACK_FUNCTIONS(type, len_type) \
 static inline bool type##_stack_empty(const type##_stack_s *const restrict stack) \
 { \
    assert(stack); \
@@ -57,10 +117,14 @@ static inline bool type##_stack_full(const type##_stack_s *const restrict stack)
    return stack->len == stack->size; \
 } \
 bool type##_stack_resize(type##_stack_s *const restrict); \
+bool type##_stack_reserve(type##_stack_s *const restrict, const len_type); \
+bool type##_stack_shrink_to_fit(type##_stack_s *const restrict); \
 void type##_stack_clear(type##_stack_s *const restrict); \
 void type##_stack_delete(type##_stack_s *const restrict); \
 bool type##_stack_push(type##_stack_s *const restrict, const type); \
+bool type##_stack_push_n(type##_stack_s *const restrict, const type *const restrict, const len_type); \
 bool type##_stack_pop(type##_stack_s *const restrict); \
+len_type type##_stack_pop_n(type##_stack_s *const restrict, type *const restrict, const len_type); \
 type type##_stack_peek(const type##_stack_s *const restrict); \
 void type##_stack_reverse(type##_stack_s *const restrict);
 
@@ -83,6 +147,11 @@ void type##_stack_reverse(type##_stack_s *const restrict);
  * Notes:
  *    Use only in a source (.c) file
  *    Use in combination with DEFINE_STACK(...)
+ *    Capacities stay on the init_size * growth_factor^k sequence: reserve
+ *    jumps straight to the first one that fits, shrink_to_fit drops to the
+ *    smallest one that still holds the elements, or back to the inline buffer.
+ *    push_n/pop_n move a block with one MEMORY_COPY, in stack order: pop_n
+ *    returns the top elements oldest first, as push_n took them.
  */
 #define GENERATE_STACK(type, len_type, init_size, growth_factor, validate_value_fn, alloc_fn, realloc_fn, free_fn) \
    static_assert(init_size > 1, "Warning: init_size too small"); \
@@ -98,34 +167,135 @@ void type##_stack_reverse(type##_stack_s *const restrict);
    assert_type(realloc_fn, void* (void*, size_t)); \
    assert_type(free_fn, void (void*)); \
 \
-bool type##_stack_resize(type##_stack_s *const restrict stack) \
+static inline void *type##_stack_mem_alloc(const type##_stack_s *const restrict stack, const size_t size) \
 { \
-   assert(stack); \
-   void *tmp; \
+   (void)stack; \
+   return alloc_fn(size); \
+} \
+static inline void *type##_stack_mem_realloc(const type##_stack_s *const restrict stack, void *const ptr, const size_t size) \
+{ \
+   (void)stack; \
+   return realloc_fn(ptr, size); \
+} \
+static inline void type##_stack_mem_free(const type##_stack_s *const restrict stack, void *const ptr) \
+{ \
+   (void)stack; \
+   free_fn(ptr); \
+} \
+GENERATE_STACK_FUNCTIONS(type, len_type, init_size, growth_factor, validate_value_fn)
+
+
+/**
+ * GENERATE_STACK_WITH_ALLOCATOR macro
+ * ----------------
+ * Implements the stack functions for a type declared with
+ * DEFINE_STACK_WITH_ALLOCATOR(...), allocating through each stack's allocator.
+ *
+ * Parameters:
+ *   As GENERATE_STACK(...), without alloc_fn, realloc_fn and free_fn
+ *
+ * Output:
+ *   Implementation of stack for type
+ *
+ * Notes:
+ *    Use only in a source (.c) file
+ *    Use in combination with DEFINE_STACK_WITH_ALLOCATOR(...), Ensure macro arguments match
+ */
+#define GENERATE_STACK_WITH_ALLOCATOR(type, len_type, init_size, growth_factor, validate_value_fn) \
+   static_assert(init_size > 1, "Warning: init_size too small"); \
+   static_assert(init_size < 256, "Warning: init_size too big"); \
+   static_assert(init_size != 0 && (init_size & (init_size - 1)) == 0, "Warning: init_size must be a power of 2"); /* resize optimization */ \
+   static_assert(growth_factor > 1, "Warning: growth_factor too small"); \
+   static_assert(growth_factor < 32,  "Warning: growth_factor too big"); \
+   static_assert(growth_factor != 0 && (growth_factor & (growth_factor - 1)) == 0, "Warning: growth_factor must be a power of 2"); /* resize optimization */ \
+   assert_istype(type); \
+   assert_istype(len_type); \
+   assert_type(validate_value_fn((type){0}), bool); \
 \
-   if (stack->size > (len_type)(-1) / growth_factor) /* Prevent overflow */ \
-      return false; \
-   len_type new_size = stack->size * growth_factor; \
+static inline void *type##_stack_mem_alloc(const type##_stack_s *const restrict stack, const size_t size) \
+{ \
+   return stack->allocator->alloc(stack->allocator->context, size); \
+} \
+static inline void *type##_stack_mem_realloc(const type##_stack_s *const restrict stack, void *const ptr, const size_t size) \
+{ \
+   return stack->allocator->realloc(stack->allocator->context, ptr, size); \
+} \
+static inline void type##_stack_mem_free(const type##_stack_s *const restrict stack, void *const ptr) \
+{ \
+   stack->allocator->free(stack->allocator->context, ptr); \
+} \
+GENERATE_STACK_FUNCTIONS(type, len_type, init_size, growth_factor, validate_value_fn)
+
+
+/* Shared by GENERATE_STACK and GENERATE_STACK_WITH_ALLOCATOR, which define type##_stack_mem_* */
+#define GENERATE_STACK_FUNCTIONS(type, len_type, init_size, growth_factor, validate_value_fn) \
+/* Move the elements to a heap buffer of new_size >= len */ \
+static bool type##_stack_reallocate(type##_stack_s *const restrict stack, const len_type new_size) \
+{ \
+   void *tmp; \
 \
    if (stack->values == stack->inline_buffer) \
    { \
-      tmp = alloc_fn(sizeof(type) * new_size); \
+      tmp = type##_stack_mem_alloc(stack, sizeof(type) * new_size); \
       if (!tmp)  \
          return false; \
       MEMORY_COPY(tmp, stack->values, stack->len * sizeof(type)); \
    } \
    else \
    { \
-      tmp = realloc_fn(stack->values, sizeof(type) * new_size); \
+      tmp = type##_stack_mem_realloc(stack, stack->values, sizeof(type) * new_size); \
       if (!tmp)  \
          return false; \
    } \
 \
    stack->size = new_size; \
    stack->values = (type*)tmp; \
+   MORSE_STATS_ADD(stack_resizes, 1); \
    return true; \
 } \
 \
+bool type##_stack_resize(type##_stack_s *const restrict stack) \
+{ \
+   assert(stack); \
+   if (stack->size > (len_type)(-1) / growth_factor) /* Prevent overflow */ \
+      return false; \
+   return type##_stack_reallocate(stack, stack->size * growth_factor); \
+} \
+\
+bool type##_stack_reserve(type##_stack_s *const restrict stack, const len_type capacity) \
+{ \
+   assert(stack); \
+   len_type new_size = stack->size; \
+   while (new_size < capacity) \
+   { \
+      if (new_size > (len_type)(-1) / growth_factor) /* Prevent overflow */ \
+         return false; \
+      new_size *= growth_factor; \
+   } \
+   return new_size == stack->size || type##_stack_reallocate(stack, new_size); \
+} \
+\
+bool type##_stack_shrink_to_fit(type##_stack_s *const restrict stack) \
+{ \
+   assert(stack); \
+   if (stack->values == stack->inline_buffer) \
+      return true; \
+\
+   if (stack->len <= init_size) \
+   { \
+      MEMORY_COPY(stack->inline_buffer, stack->values, stack->len * sizeof(type)); \
+      type##_stack_mem_free(stack, stack->values); \
+      stack->values = stack->inline_buffer; \
+      stack->size = init_size; \
+      return true; \
+   } \
+\
+   len_type new_size = init_size; \
+   while (new_size < stack->len) \
+      new_size *= growth_factor; \
+   return new_size == stack->size || type##_stack_reallocate(stack, new_size); \
+} \
+\
 void type##_stack_clear(type##_stack_s *const restrict stack) \
 { \
    assert(stack); \
@@ -138,7 +308,7 @@ void type##_stack_delete(type##_stack_s *const restrict stack) \
    type##_stack_clear(stack); \
    if (stack->values != stack->inline_buffer) \
    { \
-      free_fn(stack->values); \
+      type##_stack_mem_free(stack, stack->values); \
       stack->values = stack->inline_buffer; \
       stack->size = init_size; \
    } \
@@ -153,6 +323,24 @@ bool type##_stack_push(type##_stack_s *const restrict stack, const type value) \
 \
    stack->values[stack->len] = value; \
    stack->len++; \
+   MORSE_STATS_MAX(stack_peak_depth, stack->len); \
+   return true; \
+} \
+\
+bool type##_stack_push_n(type##_stack_s *const restrict stack, const type *const restrict values, const len_type count) \
+{ \
+   assert(stack); \
+   assert(values || count == 0); \
+   for (len_type i = 0; i < count; i++) \
+      assert(validate_value_fn(values[i])); \
+   if (count > (len_type)(-1) - stack->len) /* Prevent overflow */ \
+      return false; \
+   if (stack->len + count > stack->size && !type##_stack_reserve(stack, stack->len + count)) \
+      return false; \
+\
+   MEMORY_COPY(&stack->values[stack->len], values, sizeof(type) * count); \
+   stack->len += count; \
+   MORSE_STATS_MAX(stack_peak_depth, stack->len); \
    return true; \
 } \
 \
@@ -166,6 +354,16 @@ bool type##_stack_pop(type##_stack_s *const restrict stack) \
    return true; \
 } \
 \
+len_type type##_stack_pop_n(type##_stack_s *const restrict stack, type *const restrict values, const len_type count) \
+{ \
+   assert(stack); \
+   len_type taken = count < stack->len ? count : stack->len; \
+   stack->len -= taken; \
+   if (values) /* NULL only drops them */ \
+      MEMORY_COPY(values, &stack->values[stack->len], sizeof(type) * taken); \
+   return taken; \
+} \
+\
 type type##_stack_peek(const type##_stack_s *const restrict stack) \
 { \
    assert(stack); \
@@ -236,9 +434,14 @@ void type##_stack_reverse(type##_stack_s *const restrict stack) \
  * Usage:
  *   stack(int) s;
  *   stack_init(int, &s);               // Create a new int stack
+ *   stack_init_with_allocator(int, &s, &allocator); // ... growing through `allocator`
+ *   stack_reserve(int, &s, 1000);      // Room for 1000 values up front
  *   stack_push(int, &s, 42);           // Push a value
+ *   stack_push_n(int, &s, values, n);  // Push n values, the last ends on top
  *   int top = stack_peek(int, &s);     // Peek at the top value
  *   stack_pop(int, &s);                // Pop the top value
+ *   stack_pop_n(int, &s, values, n);   // Pop up to n values, returns how many
+ *   stack_shrink_to_fit(int, &s);      // Give back unused heap memory
  *   stack_clear(int, &s);              // Reset the stack
  *   stack_delete(int, &s);             // Free any heap memory
  */
@@ -247,11 +450,26 @@ void type##_stack_reverse(type##_stack_s *const restrict stack) \
       type##_stack_init((stack)) \
    )
 
+#define stack_init_with_allocator(type, stack, allocator) \
+   typecheck_stack_ptr(stack, type, \
+      type##_stack_init_with_allocator((stack), (allocator)) \
+   )
+
 #define stack_resize(type, stack) \
    typecheck_stack_ptr(stack, type, \
       type##_stack_resize((stack)) \
    )
 
+#define stack_reserve(type, stack, capacity) \
+   typecheck_stack_ptr(stack, type, \
+      type##_stack_reserve((stack), (capacity)) \
+   )
+
+#define stack_shrink_to_fit(type, stack) \
+   typecheck_stack_ptr(stack, type, \
+      type##_stack_shrink_to_fit((stack)) \
+   )
+
 #define stack_clear(type, stack) \
    typecheck_stack_ptr(stack, type, \
       type##_stack_clear((stack)) \
@@ -277,11 +495,21 @@ void type##_stack_reverse(type##_stack_s *const restrict stack) \
       type##_stack_push((stack), (value)) \
    )
 
+#define stack_push_n(type, stack, values, count) \
+   typecheck_stack_ptr(stack, type, \
+      type##_stack_push_n((stack), (values), (count)) \
+   )
+
 #define stack_pop(type, stack) \
    typecheck_stack_ptr(stack, type, \
       type##_stack_pop((stack)) \
    )
 
+#define stack_pop_n(type, stack, values, count) \
+   typecheck_stack_ptr(stack, type, \
+      type##_stack_pop_n((stack), (values), (count)) \
+   )
+
 #define stack_peek(type, stack) \
    typecheck_stack_ptr(stack, type, \
       type##_stack_peek((stack)) \
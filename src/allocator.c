@@ -0,0 +1,29 @@
+#include "allocator.h"
+#include "morse-stats.h"
+#include <stdlib.h>
+
+
+static void* malloc_alloc(void* context, size_t size)
+{
+    (void)context;
+    void* ptr = malloc(size);
+    MORSE_STATS_MALLOC(ptr, size);
+    return ptr;
+}
+
+static void* malloc_realloc(void* context, void* ptr, size_t size)
+{
+    (void)context;
+    void* moved = realloc(ptr, size);
+    MORSE_STATS_REALLOC(moved, size);
+    return moved;
+}
+
+static void malloc_free(void* context, void* ptr)
+{
+    (void)context;
+    MORSE_STATS_FREE(ptr);
+    free(ptr);
+}
+
+const Allocator ALLOCATOR_MALLOC = { malloc_alloc, malloc_realloc, malloc_free, NULL };
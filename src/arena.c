@@ -0,0 +1,196 @@
+#include "arena.h"
+#include "memory-copy.h"
+#include "morse-stats.h"
+#include <stdalign.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+
+static _Thread_local Arena* thread_arena = NULL;
+
+static size_t align_up(size_t size)
+{
+    return (size + alignof(max_align_t) - 1) & ~(alignof(max_align_t) - 1);
+}
+
+void arena_init(Arena* const arena, size_t block_size)
+{
+    arena->head = NULL;
+    arena->last = NULL;
+    arena->block_size = block_size > 0 ? align_up(block_size) : ARENA_DEFAULT_BLOCK_SIZE;
+    arena->blocks = 0;
+}
+
+static ArenaBlock* arena_block_new(Arena* const arena, size_t capacity)
+{
+    ArenaBlock* block = malloc(sizeof(ArenaBlock) + capacity);
+    MORSE_STATS_MALLOC(block, sizeof(ArenaBlock) + capacity);
+    if (!block) { return NULL; }
+    block->next = arena->head;
+    block->capacity = capacity;
+    block->used = 0;
+    arena->head = block;
+    arena->blocks++;
+    return block;
+}
+
+void* arena_alloc(Arena* const arena, size_t size)
+{
+    if (size > SIZE_MAX - alignof(max_align_t)) { return NULL; }
+    size = align_up(size > 0 ? size : 1);
+
+    ArenaBlock* block = arena->head;
+    if (!block || block->capacity - block->used < size)
+    {
+        block = arena_block_new(arena, size > arena->block_size ? size : arena->block_size);
+        if (!block) { return NULL; }
+    }
+
+    void* ptr = (char*)block->data + block->used;
+    block->used += size;
+    arena->last = ptr;
+    return ptr;
+}
+
+// Grows the most recent allocation in place when the block has room, otherwise
+// moves it. The old size is not recorded, so a moved allocation copies everything
+// up to the end of its block's used bytes, which always covers it.
+void* arena_realloc(Arena* const arena, void* ptr, size_t size)
+{
+    if (!ptr) { return arena_alloc(arena, size); }
+    if (size > SIZE_MAX - alignof(max_align_t)) { return NULL; }
+
+    ArenaBlock* block = arena->head;
+    while (block && !((char*)ptr >= (char*)block->data && (char*)ptr < (char*)block->data + block->used))
+    {
+        block = block->next;
+    }
+    if (!block) { return NULL; }
+
+    size_t offset = (size_t)((char*)ptr - (char*)block->data);
+    if (ptr == arena->last && block == arena->head && align_up(size) <= block->capacity - offset)
+    {
+        block->used = offset + align_up(size > 0 ? size : 1);
+        return ptr;
+    }
+
+    size_t available = block->used - offset;
+    void* moved = arena_alloc(arena, size);
+    if (!moved) { return NULL; }
+    MEMORY_COPY(moved, ptr, size < available ? size : available);
+    return moved;
+}
+
+void arena_free(Arena* const arena, void* ptr)
+{
+    if (!ptr || ptr != arena->last) return;
+    ArenaBlock* block = arena->head;
+    block->used = (size_t)((char*)ptr - (char*)block->data);
+    arena->last = NULL;
+}
+
+// Forget every allocation but keep the newest block for reuse
+void arena_reset(Arena* const arena)
+{
+    ArenaBlock* block = arena->head;
+    if (!block) return;
+
+    ArenaBlock* older = block->next;
+    while (older)
+    {
+        ArenaBlock* next = older->next;
+        MORSE_STATS_FREE(older);
+        free(older);
+        older = next;
+    }
+    block->next = NULL;
+    block->used = 0;
+    arena->last = NULL;
+}
+
+void arena_delete(Arena* const arena)
+{
+    ArenaBlock* block = arena->head;
+    while (block)
+    {
+        ArenaBlock* next = block->next;
+        MORSE_STATS_FREE(block);
+        free(block);
+        block = next;
+    }
+    arena->head = NULL;
+    arena->last = NULL;
+}
+
+Arena* arena_thread_bind(Arena* const arena)
+{
+    Arena* previous = thread_arena;
+    thread_arena = arena;
+    return previous;
+}
+
+void* arena_thread_alloc(size_t size)
+{
+    if (thread_arena) { return arena_alloc(thread_arena, size); }
+    void* ptr = malloc(size);
+    MORSE_STATS_MALLOC(ptr, size);
+    return ptr;
+}
+
+void* arena_thread_realloc(void* ptr, size_t size)
+{
+    if (thread_arena) { return arena_realloc(thread_arena, ptr, size); }
+    void* moved = realloc(ptr, size);
+    MORSE_STATS_REALLOC(moved, size);
+    return moved;
+}
+
+void arena_thread_free(void* ptr)
+{
+    if (thread_arena) arena_free(thread_arena, ptr);
+    else
+    {
+        MORSE_STATS_FREE(ptr);
+        free(ptr);
+    }
+}
+
+static void* arena_context_alloc(void* context, size_t size)
+{
+    return arena_alloc(context, size);
+}
+
+static void* arena_context_realloc(void* context, void* ptr, size_t size)
+{
+    return arena_realloc(context, ptr, size);
+}
+
+static void arena_context_free(void* context, void* ptr)
+{
+    arena_free(context, ptr);
+}
+
+Allocator arena_allocator(Arena* const arena)
+{
+    return (Allocator){ arena_context_alloc, arena_context_realloc, arena_context_free, arena };
+}
+
+static void* thread_context_alloc(void* context, size_t size)
+{
+    (void)context;
+    return arena_thread_alloc(size);
+}
+
+static void* thread_context_realloc(void* context, void* ptr, size_t size)
+{
+    (void)context;
+    return arena_thread_realloc(ptr, size);
+}
+
+static void thread_context_free(void* context, void* ptr)
+{
+    (void)context;
+    arena_thread_free(ptr);
+}
+
+const Allocator ARENA_THREAD_ALLOCATOR = { thread_context_alloc, thread_context_realloc, thread_context_free, NULL };
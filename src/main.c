@@ -1,51 +1,190 @@
 #define _GNU_SOURCE
 #include "morse.h"
+#include "morse-audio.h"
+#include "morse-batch.h"
+#include "morse-cache.h"
+#include "morse-parallel.h"
+#include "morse-server.h"
+#include "morse-stats.h"
+#include "morse-tables.h"
+#include "morse-timing.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <getopt.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 #include <sys/types.h>
+#include <unistd.h>
 
 
-static const char* MORSE_CODE_SEQUENCE[] = {
-    ".-", "-...", "-.-.", "-..", ".", "..-.", "--.", "....", "..",
-    ".---", "-.-", ".-..", "--", "-.", "---", ".--.", "--.-", ".-.",
-    "...", "-", "..-", "...-", ".--", "-..-", "-.--", "--..", ".----",
-    "..---", "...--", "....-", ".....", "-....", "--...", "---..", "----.", "-----"
-};
+#define STREAM_CHUNK_SIZE (64 * 1024)
 
-static const char ALPHABET[] = {
-    'A','B','C','D','E','F','G','H','I','J','K','L','M',
-    'N','O','P','Q','R','S','T','U','V','W','X','Y','Z',
-    '0','1','2','3','4','5','6','7','8','9'
+static const struct option LONG_OPTIONS[] = {
+    { "decode", no_argument, NULL, 'd' },
+    { "encode", no_argument, NULL, 'e' },
+    { "stream", no_argument, NULL, 's' },
+    { "jobs", required_argument, NULL, 'j' },
+    { "serve", required_argument, NULL, 'S' },
+    { "connect", required_argument, NULL, 'C' },
+    { "batch", no_argument, NULL, 'b' },
+    { "manifest", required_argument, NULL, 'M' },
+    { "suffix", required_argument, NULL, 'X' },
+    { "stats", optional_argument, NULL, 'T' },
+    { "audio", no_argument, NULL, 'A' },
+    { "raw", no_argument, NULL, 'R' },
+    { "wpm", required_argument, NULL, 'W' },
+    { "farnsworth", required_argument, NULL, 'F' },
+    { "tone", required_argument, NULL, 'N' },
+    { "rate", required_argument, NULL, 'Q' },
+    { "rise", required_argument, NULL, 'E' },
+    { "timing", no_argument, NULL, 'K' },
+    { "word-cache", optional_argument, NULL, 'Y' },
+    { "help", no_argument, NULL, 'h' },
+    { NULL, 0, NULL, 0 }
 };
 
-static const size_t ALPHABET_SIZE = sizeof(ALPHABET) / sizeof(ALPHABET[0]);
+/* Input text, mapped straight from a file or held on the heap */
+typedef struct InputBuffer {
+    const char* data;
+    size_t length;
+    void* mapping; /* NULL unless the file is mmap'd */
+    size_t mapping_size;
+    char* heap;
+} InputBuffer;
+
+bool open_input(const char* filename, InputBuffer* input);
+void close_input(InputBuffer* input);
+int run_stream(int mode, const char* filename);
+int run_client(const char* socket_path, int mode, const char* filename);
+int run_batch(int mode, char** paths, size_t count, const char* manifest, const char* suffix, size_t jobs);
+int run_audio(const char* filename, const MorseAudioConfig* config, bool raw);
+int run_audio_decode(const char* filename, const MorseAudioConfig* config, bool raw);
+int run_timing(const char* filename);
+char* encode_cached(const InputBuffer* input, size_t budget);
+char* decode_cached(const InputBuffer* input, size_t budget, size_t* error_offset);
+void write_cache_stats(const MorseCacheStats* stats);
+bool parse_number(const char* text, double* value);
+void print_usage(const char* program);
+void write_stats(void);
 
-void populate_morse_tree(BTreeNode* root);
-char* read_file(const char* filename);
+/* --stats destination, NULL when not asked for */
+static const char* stats_path = NULL;
 
 
-int main(int argc, char const *argv[])
+int main(int argc, char *argv[])
 {
-    BTreeNode* root = morse_tree_init();
-    if (!root)
-    {
-        fprintf(stderr, "Memory error\n");
-        return 1; 
+    int mode = -1; // 1: Morse->Alnum, 2: Alnum->Morse */
+    bool stream = false;
+    size_t jobs = 0; /* 0: not given, one thread (all cores in batch mode) */
+    bool batch = false;
+    const char* manifest = NULL;
+    const char* suffix = NULL;
+    const char* serve_path = NULL;
+    const char* connect_path = NULL;
+    bool audio = false;
+    bool raw = false;
+    bool timing = false;
+    size_t word_cache = 0; /* cache budget in bytes, 0 when off */
+    MorseAudioConfig audio_config = MORSE_AUDIO_CONFIG_DEFAULT;
+    double number = 0;
+
+    int option;
+    while ((option = getopt_long(argc, argv, "desbj:h", LONG_OPTIONS, NULL)) != -1) {
+        switch (option) {
+            case 'd': mode = 1; break;
+            case 'e': mode = 2; break;
+            case 's': stream = true; break;
+            case 'b': batch = true; break;
+            case 'M': manifest = optarg; batch = true; break;
+            case 'X': suffix = optarg; break;
+            case 'j': {
+                char* end = NULL;
+                unsigned long value = strtoul(optarg, &end, 10);
+                if (!end || *end != '\0' || value == 0 || value > MORSE_PARALLEL_MAX_THREADS) {
+                    fprintf(stderr, "Invalid job count: %s\n", optarg);
+                    return 1;
+                }
+                jobs = (size_t)value;
+                break;
+            }
+            case 'S': serve_path = optarg; break;
+            case 'C': connect_path = optarg; break;
+            case 'T': stats_path = optarg ? optarg : "-"; break;
+            case 'A': audio = true; break;
+            case 'R': raw = true; audio = true; break;
+            case 'K': timing = true; break;
+            case 'Y': {
+                char* end = NULL;
+                unsigned long value = optarg ? strtoul(optarg, &end, 10) : MORSE_CACHE_DEFAULT_BUDGET;
+                if ((optarg && (!end || *end != '\0')) || value == 0) {
+                    fprintf(stderr, "Invalid cache size: %s\n", optarg);
+                    return 1;
+                }
+                word_cache = (size_t)value;
+                break;
+            }
+            case 'W':
+            case 'F':
+            case 'N':
+            case 'Q':
+            case 'E':
+                if (!parse_number(optarg, &number)) {
+                    fprintf(stderr, "Invalid number: %s\n", optarg);
+                    return 1;
+                }
+                if (option == 'W') audio_config.wpm = number;
+                else if (option == 'F') audio_config.farnsworth_wpm = number;
+                else if (option == 'N') audio_config.frequency = number;
+                else if (option == 'Q') audio_config.sample_rate = number >= 1 && number <= 1e6 ? (unsigned)number : 0;
+                else audio_config.rise_time = number / 1000.0;
+                audio = true;
+                break;
+            case 'h': print_usage(argv[0]); return 0;
+            default: print_usage(argv[0]); return 1;
+        }
     }
-    populate_morse_tree(root);
+    const char* input_path = optind < argc ? argv[optind] : NULL;
+    if (stats_path) atexit(write_stats);
 
+    /* the alphabet is compiled in, startup builds nothing */
+    const MorseDecodeTable* decode_table = &MORSE_DECODE_TABLE_DEFAULT;
+    const MorseEncodeTable* encode_table = &MORSE_ENCODE_TABLE_DEFAULT;
+
+    if (batch) {
+        return run_batch(mode == 2 ? 2 : 1, argv + optind, (size_t)(argc - optind), manifest, suffix, jobs);
+    }
+    if (jobs == 0) jobs = 1;
+    if (serve_path) {
+        return morse_server_run(serve_path, encode_table, decode_table);
+    }
+    if (connect_path) {
+        return run_client(connect_path, mode == 2 ? 2 : 1, input_path);
+    }
+    if (timing) {
+        return run_timing(input_path);
+    }
+    if (audio) {
+        if (mode == 1) return run_audio_decode(input_path, &audio_config, raw);
+        return run_audio(input_path, &audio_config, raw);
+    }
+
+    /* a mode without a file reads standard input as a stream */
+    if (stream || (mode != -1 && !input_path)) {
+        return run_stream(mode == 2 ? 2 : 1, input_path);
+    }
+
+    InputBuffer input = { NULL, 0, NULL, 0, NULL };
     char* input_message = NULL;
-    int mode = -1; // 1: Morse->Alnum, 2: Alnum->Morse */
 
-    if (argc > 1) {
-        input_message = read_file(argv[1]);
-        if (!input_message) {
-            fprintf(stderr, "Failed to read file: %s\n", argv[1]);
-            morse_tree_delete(root);
+    if (input_path) {
+        if (!open_input(input_path, &input)) {
+            fprintf(stderr, "Failed to read file: %s\n", input_path);
             return 1;
         }
-        mode = 1;
+        if (mode == -1) mode = 1;
     } else {
         /* interactive prompt for mode */
         printf("\nChoose mode:\n");
@@ -53,7 +192,6 @@ int main(int argc, char const *argv[])
         printf("Enter 1, 2 or 3: ");
         if (scanf("%d%*c", &mode) != 1) {
             fprintf(stderr, "Invalid input\n");
-            morse_tree_delete(root);
             return 1;
         }
         if (mode == 1) {
@@ -63,10 +201,11 @@ int main(int argc, char const *argv[])
             if (linelen <= 0) input_message = NULL;
             if (input_message) {
                 /* trim newline */
-                size_t n = strlen(input_message);
+                size_t n = (size_t)linelen;
                 while (n > 0 && (input_message[n-1] == '\n' || input_message[n-1] == '\r')) {
                     input_message[--n] = '\0';
                 }
+                input.length = n;
             }
         } else if (mode == 2) {
             printf("\nEnter alphabetical text to convert (letters & spaces):\n");
@@ -78,88 +217,614 @@ int main(int argc, char const *argv[])
                 while (n > 0 && (input_message[n-1] == '\n' || input_message[n-1] == '\r')) {
                     input_message[--n] = '\0';
                 }
+                input.length = n;
             }
         } else if (mode == 3)
         {
             printf("\nMorse Code Dictionary:\n");
-            morse_tree_print(root);
+            morse_tree_print(morse_tree_default());
             return 0;
         } else {
             fprintf(stderr, "Unknown mode\n");
-            morse_tree_delete(root);
             return 1;
         }
+        input.heap = input_message;
+        input.data = input_message;
     }
 
     if (mode == 1) {
-        if (!input_message) {
+        if (!input.data) {
             fprintf(stderr, "No Morse message provided\n");
-            morse_tree_delete(root);
             return 1;
         }
-        if (!is_valid_morse_message(input_message)) {
-            fprintf(stderr, "Error: The Morse code message contains invalid characters.\n");
-            free(input_message);
-            morse_tree_delete(root);
+        /* validation happens while decoding, the input is only scanned once */
+        size_t error_offset = MORSE_DECODE_NO_ERROR;
+        char* decoded = jobs > 1
+            ? morse_decode_parallel_with_table(decode_table, input.data, input.length, jobs, MORSE_DECODE_STRICT, &error_offset)
+            : word_cache > 0
+            ? decode_cached(&input, word_cache, &error_offset)
+            : morse_decode_checked_with_table(decode_table, input.data, input.length, MORSE_DECODE_STRICT, &error_offset);
+        if (error_offset != MORSE_DECODE_NO_ERROR) {
+            fprintf(stderr, "Error: The Morse code message contains invalid characters (first at offset %zu).\n", error_offset);
+            close_input(&input);
+            return 1;
+        }
+        if (!decoded) {
+            fprintf(stderr, "Conversion failed\n");
+            close_input(&input);
             return 1;
         }
 
-        printf("\nOriginal Morse Code: %s\n", input_message);
-
-        char* decoded = morse_decode(root, input_message);
-        printf("Decoded Message: %s\n", decoded ? decoded : "(null)\n");
+        printf("\nOriginal Morse Code: ");
+        fwrite(input.data, 1, input.length, stdout);
+        printf("\nDecoded Message: %s\n", decoded ? decoded : "(null)\n");
 
-        free(decoded);
-        free(input_message);
+        morse_free(decoded);
+        close_input(&input);
     } else if (mode == 2) {
         // Alphabetical -> Morse */
-        if (!input_message) {
+        if (!input.data) {
             fprintf(stderr, "No text provided\n");
-            morse_tree_delete(root);
             return 1;
         }
-        char* morse = morse_encode(root, input_message);
+        char* morse = jobs > 1
+            ? morse_encode_parallel_with_table(encode_table, input.data, input.length, jobs)
+            : word_cache > 0
+            ? encode_cached(&input, word_cache)
+            : morse_encode_n_with_table(encode_table, input.data, input.length);
         if (!morse) {
             fprintf(stderr, "Conversion failed\n");
-            free(input_message);
-            morse_tree_delete(root);
+            close_input(&input);
             return 1;
         }
-        printf("\nAlphabetical input: %s\n", input_message);
-        printf("Converted Morse: %s\n", morse);
+        printf("\nAlphabetical input: ");
+        fwrite(input.data, 1, input.length, stdout);
+        printf("\nConverted Morse: %s\n", morse);
 
-        free(morse);
-        free(input_message);
+        morse_free(morse);
+        close_input(&input);
     }
-    morse_tree_delete(root);
     return 0;
 }
 
 
-void populate_morse_tree(BTreeNode* root)
+/* Serial encode through a word cache of `budget` bytes, its statistics go to stderr */
+char* encode_cached(const InputBuffer* input, size_t budget)
 {
-    for (size_t i = 0; i < ALPHABET_SIZE; i++)
-    {
-        morse_tree_insert(root, MORSE_CODE_SEQUENCE[i], ALPHABET[i]);
+    MorseEncodeCache cache;
+    if (!morse_encode_cache_init(&cache, &MORSE_ENCODE_TABLE_DEFAULT, budget)) {
+        fprintf(stderr, "A word cache of %zu bytes is too small or cannot be allocated\n", budget);
+        morse_encode_cache_delete(&cache);
+        return NULL;
     }
+    char* morse = morse_encode_cached(&cache, input->data, input->length);
+    write_cache_stats(&cache.words.stats);
+    morse_encode_cache_delete(&cache);
+    return morse;
 }
 
-char* read_file(const char* filename)
+/* Serial strict decode through a word cache of `budget` bytes, its statistics go to stderr */
+char* decode_cached(const InputBuffer* input, size_t budget, size_t* error_offset)
 {
-    FILE* file = fopen(filename, "rb");
-    if (!file) return NULL;
-    if (fseek(file, 0, SEEK_END) != 0) { fclose(file); return NULL; }
+    MorseDecodeCache cache;
+    if (!morse_decode_cache_init(&cache, &MORSE_DECODE_TABLE_DEFAULT, budget)) {
+        fprintf(stderr, "A word cache of %zu bytes is too small or cannot be allocated\n", budget);
+        morse_decode_cache_delete(&cache);
+        return NULL;
+    }
+    char* text = morse_decode_cached(&cache, input->data, input->length, MORSE_DECODE_STRICT, error_offset);
+    write_cache_stats(&cache.words.stats);
+    morse_decode_cache_delete(&cache);
+    return text;
+}
 
-    long file_size = ftell(file);
-    if (file_size < 0) { fclose(file); return NULL; }
-    rewind(file);
+void write_cache_stats(const MorseCacheStats* stats)
+{
+    fflush(stdout);
+    fprintf(stderr, "Word cache: %llu hits, %llu misses, %llu evictions, %llu bypasses\n",
+            (unsigned long long)stats->hits, (unsigned long long)stats->misses,
+            (unsigned long long)stats->evictions, (unsigned long long)stats->bypasses);
+}
+
+/* Regular files are mapped read-only and used in place; pipes and devices are read() into the heap.
+   A NULL filename reads standard input. */
+bool open_input(const char* filename, InputBuffer* input)
+{
+    *input = (InputBuffer){ NULL, 0, NULL, 0, NULL };
+    int fd = filename ? open(filename, O_RDONLY) : STDIN_FILENO;
+    if (fd < 0) return false;
+
+    struct stat info;
+    if (fstat(fd, &info) == 0 && S_ISREG(info.st_mode) && info.st_size > 0) {
+        void* mapping = mmap(NULL, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (mapping != MAP_FAILED) {
+            madvise(mapping, (size_t)info.st_size, MADV_SEQUENTIAL);
+            input->mapping = mapping;
+            input->mapping_size = (size_t)info.st_size;
+            input->data = mapping;
+            input->length = (size_t)info.st_size;
+        }
+    }
+
+    if (!input->mapping) {
+        size_t cap = 4096;
+        size_t len = 0;
+        char* buffer = malloc(cap);
+        ssize_t got = 0;
+        while (buffer && (got = read(fd, buffer + len, cap - len)) > 0) {
+            len += (size_t)got;
+            if (len == cap) {
+                char* tmp = realloc(buffer, cap * 2);
+                if (!tmp) { free(buffer); buffer = NULL; break; }
+                buffer = tmp;
+                cap *= 2;
+            }
+        }
+        if (!buffer || got < 0) {
+            free(buffer);
+            if (filename) close(fd);
+            return false;
+        }
+        input->heap = buffer;
+        input->data = buffer;
+        input->length = len;
+    }
+    if (filename) close(fd);
 
-    char* buffer = malloc((size_t)file_size + 1);
-    if (!buffer) { fclose(file); return NULL; }
-    size_t got = fread(buffer, 1, (size_t)file_size, file);
-    fclose(file);
-    buffer[got] = '\0';
     /* trim trailing newlines */
-    while (got > 0 && (buffer[got-1] == '\n' || buffer[got-1] == '\r')) { buffer[--got] = '\0'; }
-    return buffer;
+    while (input->length > 0 && (input->data[input->length-1] == '\n' || input->data[input->length-1] == '\r')) {
+        input->length--;
+    }
+    return true;
+}
+
+void close_input(InputBuffer* input)
+{
+    if (input->mapping) munmap(input->mapping, input->mapping_size);
+    free(input->heap);
+    *input = (InputBuffer){ NULL, 0, NULL, 0, NULL };
+}
+
+/* Translate in fixed-size chunks, writing output as soon as each chunk is done */
+int run_stream(int mode, const char* filename)
+{
+    int fd = filename ? open(filename, O_RDONLY) : STDIN_FILENO;
+    if (fd < 0) {
+        fprintf(stderr, "Failed to read file: %s\n", filename);
+        return 1;
+    }
+
+    static char input[STREAM_CHUNK_SIZE];
+    char* output = malloc(MORSE_ENCODER_FEED_BOUND(STREAM_CHUNK_SIZE));
+    if (!output) {
+        fprintf(stderr, "Memory allocation failed\n");
+        if (filename) close(fd);
+        return 1;
+    }
+
+    MorseDecoder decoder;
+    MorseEncoder encoder;
+    if (mode == 1) morse_decoder_init_with_table(&decoder, &MORSE_DECODE_TABLE_DEFAULT, MORSE_DECODE_STRICT);
+    else morse_encoder_init_with_table(&encoder, &MORSE_ENCODE_TABLE_DEFAULT);
+
+    int status = 0;
+    size_t held_newlines = 0; /* only valid at the very end of Morse input */
+    ssize_t got;
+    while ((got = read(fd, input, sizeof(input))) > 0) {
+        size_t len = (size_t)got;
+        size_t written = 0;
+        if (mode == 2) {
+            written = morse_encoder_feed(&encoder, input, len, output);
+        } else {
+            size_t trailing = 0;
+            while (trailing < len && (input[len - 1 - trailing] == '\n' || input[len - 1 - trailing] == '\r')) trailing++;
+            bool decoded = true;
+            if (held_newlines > 0 && trailing < len) {
+                decoded = morse_decoder_feed(&decoder, "\n", 1, output, &written);
+                held_newlines = 0;
+            }
+            if (decoded) decoded = morse_decoder_feed(&decoder, input, len - trailing, output, &written);
+            held_newlines += trailing;
+            if (!decoded) {
+                fwrite(output, 1, written, stdout);
+                fprintf(stderr, "\nError: The Morse code message contains invalid characters (first at offset %zu).\n", decoder.error_offset);
+                status = 1;
+                break;
+            }
+        }
+        fwrite(output, 1, written, stdout);
+        fflush(stdout);
+    }
+    if (got < 0) {
+        perror("read");
+        status = 1;
+    }
+
+    if (status == 0) {
+        if (mode == 1) fwrite(output, 1, morse_decoder_finish(&decoder, output), stdout);
+        else morse_encoder_finish(&encoder);
+        putchar('\n');
+    }
+    free(output);
+    if (filename) close(fd);
+    return status;
+}
+
+bool parse_number(const char* text, double* value)
+{
+    char* end = NULL;
+    *value = strtod(text, &end);
+    return end != text && *end == '\0';
+}
+
+static bool write_stdout(void* context, const void* data, size_t bytes)
+{
+    (void)context;
+    return fwrite(data, 1, bytes, stdout) == bytes;
+}
+
+/* Encode text in chunks and render every chunk; a NULL write only counts the samples */
+static bool render_text(int fd, MorseEncoder* encoder, MorseAudio* audio, char* input, char* morse, bool write)
+{
+    ssize_t got;
+    while ((got = read(fd, input, STREAM_CHUNK_SIZE)) > 0) {
+        size_t written = morse_encoder_feed(encoder, input, (size_t)got, morse);
+        if (!morse_audio_feed(audio, morse, written, write ? write_stdout : NULL, NULL)) return false;
+    }
+    morse_encoder_finish(encoder);
+    return got == 0;
+}
+
+/* Text to Morse audio on standard output. A WAV of a regular file is measured in a
+   first pass so its header carries the exact length; other input gets a streaming header. */
+int run_audio(const char* filename, const MorseAudioConfig* config, bool raw)
+{
+    MorseAudio audio;
+    if (!morse_audio_init(&audio, config)) {
+        fprintf(stderr, "Invalid audio settings\n");
+        return 1;
+    }
+    int fd = filename ? open(filename, O_RDONLY) : STDIN_FILENO;
+    char* input = malloc(STREAM_CHUNK_SIZE);
+    char* morse = malloc(MORSE_ENCODER_FEED_BOUND(STREAM_CHUNK_SIZE));
+    if (fd < 0 || !input || !morse) {
+        if (fd < 0) fprintf(stderr, "Failed to read file: %s\n", filename);
+        else fprintf(stderr, "Memory allocation failed\n");
+        if (filename && fd >= 0) close(fd);
+        free(input);
+        free(morse);
+        morse_audio_delete(&audio);
+        return 1;
+    }
+
+    MorseEncoder encoder;
+    morse_encoder_init_with_table(&encoder, &MORSE_ENCODE_TABLE_DEFAULT);
+    bool ok = true;
+    if (!raw) {
+        uint64_t samples = MORSE_AUDIO_STREAMING;
+        struct stat info;
+        if (fstat(fd, &info) == 0 && S_ISREG(info.st_mode)) {
+            ok = render_text(fd, &encoder, &audio, input, morse, false) && lseek(fd, 0, SEEK_SET) == 0;
+            samples = morse_audio_finish(&audio);
+        }
+        unsigned char header[MORSE_AUDIO_WAV_HEADER_SIZE];
+        morse_audio_wav_header(&audio, samples, header);
+        ok = ok && write_stdout(NULL, header, sizeof(header));
+    }
+    ok = ok && render_text(fd, &encoder, &audio, input, morse, true);
+    morse_audio_finish(&audio);
+    ok = fflush(stdout) == 0 && ok;
+    if (!ok) perror("audio");
+
+    if (filename) close(fd);
+    free(input);
+    free(morse);
+    morse_audio_delete(&audio);
+    return ok ? 0 : 1;
+}
+
+static bool read_exact(int fd, void* buffer, size_t length)
+{
+    char* out = buffer;
+    while (length > 0) {
+        ssize_t got = read(fd, out, length);
+        if (got < 0 && errno == EINTR) continue;
+        if (got <= 0) return false;
+        out += got;
+        length -= (size_t)got;
+    }
+    return true;
+}
+
+static uint32_t read_u32(const unsigned char* in)
+{
+    return (uint32_t)in[0] | (uint32_t)in[1] << 8 | (uint32_t)in[2] << 16 | (uint32_t)in[3] << 24;
+}
+
+/* Read a WAV header up to its sample data, which must be 16-bit mono PCM */
+static bool read_wav_header(int fd, unsigned* sample_rate)
+{
+    unsigned char header[12];
+    if (!read_exact(fd, header, sizeof(header)) || memcmp(header, "RIFF", 4) != 0 || memcmp(header + 8, "WAVE", 4) != 0) {
+        return false;
+    }
+    bool format_seen = false;
+    unsigned char chunk[8];
+    while (read_exact(fd, chunk, sizeof(chunk))) {
+        uint32_t size = read_u32(chunk + 4);
+        if (memcmp(chunk, "data", 4) == 0) return format_seen;
+
+        /* chunks are padded to an even size; only the start of fmt is read */
+        uint64_t skip = (uint64_t)size + (size & 1);
+        if (memcmp(chunk, "fmt ", 4) == 0) {
+            unsigned char format[16];
+            if (size < sizeof(format) || !read_exact(fd, format, sizeof(format))) return false;
+            unsigned tag = format[0] | format[1] << 8;
+            unsigned channels = format[2] | format[3] << 8;
+            unsigned bits = format[14] | format[15] << 8;
+            if ((tag != 1 && tag != 0xFFFE) || channels != 1 || bits != 16) return false;
+            *sample_rate = read_u32(format + 4);
+            format_seen = true;
+            skip -= sizeof(format);
+        }
+        char discard[256];
+        while (skip > 0) {
+            size_t take = skip < sizeof(discard) ? (size_t)skip : sizeof(discard);
+            if (!read_exact(fd, discard, take)) return false;
+            skip -= take;
+        }
+    }
+    return false;
+}
+
+/* Morse audio to text, chunk by chunk. The tone is --tone; a WAV header sets the rate. */
+int run_audio_decode(const char* filename, const MorseAudioConfig* config, bool raw)
+{
+    int fd = filename ? open(filename, O_RDONLY) : STDIN_FILENO;
+    if (fd < 0) {
+        fprintf(stderr, "Failed to read file: %s\n", filename);
+        return 1;
+    }
+    unsigned sample_rate = config->sample_rate;
+    if (!raw && !read_wav_header(fd, &sample_rate)) {
+        fprintf(stderr, "Input is not a 16-bit mono PCM WAV (use --raw for headerless PCM)\n");
+        if (filename) close(fd);
+        return 1;
+    }
+
+    MorseAudioDecoder* decoder = malloc(sizeof(MorseAudioDecoder));
+    char* input = malloc(STREAM_CHUNK_SIZE);
+    char* output = malloc(MORSE_AUDIO_DECODER_FEED_BOUND(STREAM_CHUNK_SIZE));
+    int status = 0;
+    if (!decoder || !input || !output) {
+        fprintf(stderr, "Memory allocation failed\n");
+        status = 1;
+    } else if (!morse_audio_decoder_init(decoder, &MORSE_DECODE_TABLE_DEFAULT, sample_rate, config->frequency)) {
+        fprintf(stderr, "Invalid audio settings\n");
+        status = 1;
+    }
+
+    ssize_t got = 0;
+    while (status == 0 && (got = read(fd, input, STREAM_CHUNK_SIZE)) > 0) {
+        fwrite(output, 1, morse_audio_decoder_feed(decoder, input, (size_t)got, output), stdout);
+    }
+    if (status == 0 && got < 0) {
+        perror("read");
+        status = 1;
+    }
+    if (status == 0) {
+        fwrite(output, 1, morse_audio_decoder_finish(decoder, output), stdout);
+        putchar('\n');
+    }
+
+    if (filename) close(fd);
+    free(decoder);
+    free(input);
+    free(output);
+    return status;
+}
+
+/* One key event as text: key-down milliseconds, or key-up as a negative number */
+static size_t decode_timing_event(MorseTimingDecoder* decoder, const char* text, char* output, bool* valid)
+{
+    double duration = 0;
+    if (!parse_number(text, &duration)) {
+        *valid = false;
+        return 0;
+    }
+    return morse_timing_feed(decoder, text[0] != '-', duration < 0 ? -duration : duration, output);
+}
+
+/* Key events to text. Events are separated by whitespace or commas and may span chunks. */
+int run_timing(const char* filename)
+{
+    int fd = filename ? open(filename, O_RDONLY) : STDIN_FILENO;
+    if (fd < 0) {
+        fprintf(stderr, "Failed to read file: %s\n", filename);
+        return 1;
+    }
+
+    static char input[STREAM_CHUNK_SIZE];
+    char event[64]; /* the event in progress, terminated when it ends */
+    size_t event_len = 0;
+    char output[MORSE_TIMING_EVENT_BOUND];
+    MorseTimingDecoder decoder;
+    morse_timing_init(&decoder, &MORSE_DECODE_TABLE_DEFAULT);
+
+    bool valid = true;
+    size_t events = 0;
+    ssize_t got;
+    while (valid && (got = read(fd, input, sizeof(input))) > 0) {
+        for (ssize_t i = 0; i < got && valid; i++) {
+            char c = input[i];
+            if (c != ' ' && c != ',' && c != '\n' && c != '\r' && c != '\t') {
+                if (event_len + 1 >= sizeof(event)) valid = false;
+                else event[event_len++] = c;
+                continue;
+            }
+            if (event_len == 0) continue;
+            event[event_len] = '\0';
+            event_len = 0;
+            events++;
+            fwrite(output, 1, decode_timing_event(&decoder, event, output, &valid), stdout);
+        }
+        fflush(stdout);
+    }
+    if (valid && event_len > 0) {
+        event[event_len] = '\0';
+        events++;
+        fwrite(output, 1, decode_timing_event(&decoder, event, output, &valid), stdout);
+    }
+    if (filename) close(fd);
+
+    if (got < 0) {
+        perror("read");
+        return 1;
+    }
+    if (!valid) {
+        fprintf(stderr, "\nError: invalid key event %zu\n", events);
+        return 1;
+    }
+    fwrite(output, 1, morse_timing_finish(&decoder, output), stdout);
+    putchar('\n');
+    fflush(stdout);
+    fprintf(stderr, "Estimated speed: %.1f wpm\n", morse_timing_wpm(&decoder, 0.001));
+    return 0;
+}
+
+/* Send one request to a running server and print its reply */
+int run_client(const char* socket_path, int mode, const char* filename)
+{
+    InputBuffer input;
+    if (!open_input(filename, &input)) {
+        fprintf(stderr, "Failed to read file: %s\n", filename ? filename : "(stdin)");
+        return 1;
+    }
+
+    MorseClient* client = malloc(sizeof(MorseClient));
+    if (!client || !morse_client_connect(client, socket_path)) {
+        fprintf(stderr, "Failed to connect to %s\n", socket_path);
+        free(client);
+        close_input(&input);
+        return 1;
+    }
+
+    int status = 1;
+    MorseResponse response = { 0, NULL, 0, 0 };
+    char operation = mode == 2 ? MORSE_REQUEST_ENCODE : MORSE_REQUEST_DECODE;
+    if (!morse_client_send(client, operation, input.data, input.length) || !morse_client_receive(client, &response)) {
+        fprintf(stderr, "Request failed\n");
+    } else if (response.status != MORSE_STATUS_OK) {
+        fprintf(stderr, "Error: %s\n", response.payload);
+    } else {
+        fwrite(response.payload, 1, response.length, stdout);
+        putchar('\n');
+        status = 0;
+    }
+
+    morse_response_free(&response);
+    morse_client_close(client);
+    free(client);
+    close_input(&input);
+    return status;
+}
+
+/* Translate every path given, plus every line of the manifest, into sibling files */
+int run_batch(int mode, char** paths, size_t count, const char* manifest, const char* suffix, size_t jobs)
+{
+    InputBuffer listing = { NULL, 0, NULL, 0, NULL };
+    if (manifest && !open_input(manifest, &listing)) {
+        fprintf(stderr, "Failed to read manifest: %s\n", manifest);
+        return 1;
+    }
+
+    /* manifest lines are copied so each path can be terminated */
+    char* lines = malloc(listing.length + 1);
+    const char** all = malloc((count + (listing.length + 1) / 2 + 1) * sizeof(char*));
+    if (!lines || !all) {
+        fprintf(stderr, "Memory allocation failed\n");
+        free(lines);
+        free(all);
+        close_input(&listing);
+        return 1;
+    }
+    size_t total = 0;
+    for (size_t i = 0; i < count; i++) all[total++] = paths[i];
+    if (listing.length > 0) MEMORY_COPY(lines, listing.data, listing.length);
+    lines[listing.length] = '\0';
+    close_input(&listing);
+    for (char* line = lines; *line;) {
+        char* end = line + strcspn(line, "\r\n");
+        bool last = *end == '\0';
+        *end = '\0';
+        if (end > line) all[total++] = line;
+        if (last) break;
+        line = end + 1;
+    }
+
+    if (total == 0) {
+        fprintf(stderr, "No input files\n");
+        free(lines);
+        free(all);
+        return 1;
+    }
+    if (jobs == 0) {
+        long cores = sysconf(_SC_NPROCESSORS_ONLN);
+        jobs = cores > 0 ? (size_t)cores : 1;
+    }
+
+    size_t failed = morse_batch_run(all, total, mode == 2 ? MORSE_BATCH_ENCODE : MORSE_BATCH_DECODE, suffix, jobs,
+                                    &MORSE_ENCODE_TABLE_DEFAULT, &MORSE_DECODE_TABLE_DEFAULT);
+    fprintf(stderr, "Translated %zu of %zu files\n", total - failed, total);
+    free(lines);
+    free(all);
+    return failed > 0 ? 1 : 0;
+}
+
+/* Dump the instrumentation counters as JSON once the translator is done */
+void write_stats(void)
+{
+    if (!morse_stats_enabled()) fprintf(stderr, "Counters are not compiled in, rebuild with make stats\n");
+    FILE* file = strcmp(stats_path, "-") == 0 ? stderr : fopen(stats_path, "w");
+    if (!file) {
+        perror(stats_path);
+        return;
+    }
+    if (!morse_stats_write_json(file)) perror(stats_path);
+    if (file != stderr) fclose(file);
+}
+
+void print_usage(const char* program)
+{
+    printf("Usage: %s [options] [file...]\n", program);
+    printf("  -d, --decode   Morse code -> Alphabetical (default for files)\n");
+    printf("  -e, --encode   Alphabetical -> Morse code\n");
+    printf("  -s, --stream   Translate in fixed-size chunks with constant memory,\n");
+    printf("                 reading standard input when no file is given\n");
+    printf("  -j, --jobs N   Translate a file on N threads\n");
+    printf("  -b, --batch    Translate every file given into a sibling file, on\n");
+    printf("                 all cores unless -j is given\n");
+    printf("  --manifest F   Batch mode over the paths listed in F, one per line\n");
+    printf("  --suffix S     Batch output suffix (default .decoded or .morse)\n");
+    printf("  --serve PATH   Serve translation requests on a Unix socket\n");
+    printf("  --connect PATH Send one request to a server, reading the message\n");
+    printf("                 from the file or standard input\n");
+    printf("  --stats[=F]    On exit, write the instrumentation counters as JSON to\n");
+    printf("                 F or standard error (needs a make stats build)\n");
+    printf("  --audio        Encode the file or standard input and write it to standard\n");
+    printf("                 output as a 16-bit mono WAV\n");
+    printf("                 (with -d, decode a WAV of Morse audio to text)\n");
+    printf("  --raw          Raw 16-bit little-endian PCM instead of WAV\n");
+    printf("  --wpm N        Character speed in words per minute (default 20)\n");
+    printf("  --farnsworth N Overall speed, stretching only the gaps (default off)\n");
+    printf("  --tone HZ      Tone frequency (default 600)\n");
+    printf("  --rate HZ      Sample rate (default 8000)\n");
+    printf("  --rise MS      Raised-cosine edge length (default 5)\n");
+    printf("  --timing       Decode key events from the file or standard input:\n");
+    printf("                 milliseconds key-down, negative for key-up (\"60 -60 180\")\n");
+    printf("  --word-cache[=BYTES]\n");
+    printf("                 Encode or decode a file through a cache of whole words (default %d\n", MORSE_CACHE_DEFAULT_BUDGET);
+    printf("                 bytes), printing its hit counts to standard error\n");
+    printf("  -h, --help     Show this help\n");
+    printf("Without options or a file the translator runs interactively.\n");
 }
@@ -0,0 +1,262 @@
+#include "morse-audio.h"
+#include "memory-copy.h"
+#include <math.h>
+#include <stdlib.h>
+
+
+#define AUDIO_PI 3.14159265358979323846
+
+static const unsigned char SILENCE[4096];
+
+static size_t seconds_to_samples(double seconds, unsigned sample_rate)
+{
+    return (size_t)(seconds * (double)sample_rate + 0.5);
+}
+
+// One element of `samples` samples: a sine with raised-cosine edges, as little-endian bytes
+static unsigned char* render_element(const MorseAudioConfig* config, size_t samples)
+{
+    unsigned char* pcm = malloc(samples * 2);
+    if (!pcm) { return NULL; }
+
+    size_t edge = seconds_to_samples(config->rise_time, config->sample_rate);
+    if (edge > samples / 2) edge = samples / 2;
+    double step = 2.0 * AUDIO_PI * config->frequency / (double)config->sample_rate;
+    double peak = config->amplitude * 32767.0;
+    for (size_t i = 0; i < samples; i++)
+    {
+        double envelope = 1.0;
+        size_t from_edge = i < samples - 1 - i ? i : samples - 1 - i;
+        if (from_edge < edge) envelope = 0.5 * (1.0 - cos(AUDIO_PI * (double)from_edge / (double)edge));
+        int16_t sample = (int16_t)lrint(peak * envelope * sin(step * (double)i));
+        pcm[2 * i] = (unsigned char)((uint16_t)sample & 0xFF);
+        pcm[2 * i + 1] = (unsigned char)((uint16_t)sample >> 8);
+    }
+    return pcm;
+}
+
+bool morse_audio_init(MorseAudio* audio, const MorseAudioConfig* config)
+{
+    *audio = (MorseAudio){ 0 };
+    if (!config || config->sample_rate < 1000 || config->sample_rate > 384000) { return false; }
+    if (!(config->wpm > 0 && config->wpm <= 100)) { return false; }
+    if (!(config->farnsworth_wpm >= 0 && config->farnsworth_wpm <= 100)) { return false; }
+    if (!(config->frequency > 0 && config->frequency < config->sample_rate / 2.0)) { return false; }
+    if (!(config->rise_time >= 0 && config->rise_time < 1.0)) { return false; }
+    if (!(config->amplitude > 0 && config->amplitude <= 1.0)) { return false; }
+
+    audio->config = *config;
+    double unit = 1.2 / config->wpm;
+    audio->dot_samples = seconds_to_samples(unit, config->sample_rate);
+    audio->dash_samples = seconds_to_samples(3 * unit, config->sample_rate);
+    if (audio->dot_samples == 0) { return false; }
+
+    double letter_gap = 3 * unit;
+    double word_gap = 7 * unit;
+    double farnsworth = config->farnsworth_wpm;
+    if (farnsworth > 0 && farnsworth < config->wpm)
+    {
+        // ARRL Farnsworth timing: the extra time of a PARIS word spread over its 19 gap units
+        double delay = (60.0 * config->wpm - 37.2 * farnsworth) / (config->wpm * farnsworth);
+        letter_gap = 3 * delay / 19;
+        word_gap = 7 * delay / 19;
+    }
+    audio->gap_samples[MORSE_AUDIO_GAP_NONE] = 0;
+    audio->gap_samples[MORSE_AUDIO_GAP_ELEMENT] = audio->dot_samples;
+    audio->gap_samples[MORSE_AUDIO_GAP_LETTER] = seconds_to_samples(letter_gap, config->sample_rate);
+    audio->gap_samples[MORSE_AUDIO_GAP_WORD] = seconds_to_samples(word_gap, config->sample_rate);
+
+    audio->dot = render_element(config, audio->dot_samples);
+    audio->dash = render_element(config, audio->dash_samples);
+    if (!audio->dot || !audio->dash)
+    {
+        morse_audio_delete(audio);
+        return false;
+    }
+    audio->pending = MORSE_AUDIO_GAP_NONE;
+    return true;
+}
+
+void morse_audio_delete(MorseAudio* audio)
+{
+    free(audio->dot);
+    free(audio->dash);
+    audio->dot = NULL;
+    audio->dash = NULL;
+}
+
+static bool write_silence(size_t samples, MorseAudioWriteFn write, void* context)
+{
+    size_t bytes = samples * 2;
+    while (bytes > 0)
+    {
+        size_t take = bytes < sizeof(SILENCE) ? bytes : sizeof(SILENCE);
+        if (!write(context, SILENCE, take)) { return false; }
+        bytes -= take;
+    }
+    return true;
+}
+
+bool morse_audio_feed(MorseAudio* audio, const char* morse, size_t length, MorseAudioWriteFn write, void* context)
+{
+    for (size_t i = 0; i < length; i++)
+    {
+        char ch = morse[i];
+        if (ch == '.' || ch == '-')
+        {
+            size_t gap = audio->gap_samples[audio->pending];
+            bool dash = ch == '-';
+            size_t samples = dash ? audio->dash_samples : audio->dot_samples;
+            if (write)
+            {
+                if (!write_silence(gap, write, context)) { return false; }
+                if (!write(context, dash ? audio->dash : audio->dot, samples * 2)) { return false; }
+            }
+            audio->samples += gap + samples;
+            audio->pending = MORSE_AUDIO_GAP_ELEMENT;
+        } else if (ch == ' ')
+        {
+            if (audio->pending == MORSE_AUDIO_GAP_ELEMENT) audio->pending = MORSE_AUDIO_GAP_LETTER;
+        } else if (ch == '/')
+        {
+            if (audio->pending != MORSE_AUDIO_GAP_NONE) audio->pending = MORSE_AUDIO_GAP_WORD;
+        }
+        // Anything else, such as the '?' of an unknown character, has no sound
+    }
+    return true;
+}
+
+uint64_t morse_audio_finish(MorseAudio* audio)
+{
+    uint64_t samples = audio->samples;
+    audio->samples = 0;
+    audio->pending = MORSE_AUDIO_GAP_NONE;
+    return samples;
+}
+
+static void put_u32(unsigned char* out, uint32_t value)
+{
+    out[0] = (unsigned char)value;
+    out[1] = (unsigned char)(value >> 8);
+    out[2] = (unsigned char)(value >> 16);
+    out[3] = (unsigned char)(value >> 24);
+}
+
+static void put_u16(unsigned char* out, uint16_t value)
+{
+    out[0] = (unsigned char)value;
+    out[1] = (unsigned char)(value >> 8);
+}
+
+void morse_audio_wav_header(const MorseAudio* audio, uint64_t samples, unsigned char* header)
+{
+    // Streams, and data too large for the 32-bit sizes, get the maximum as most readers expect
+    uint32_t data_bytes = 0xFFFFFFFFu;
+    uint32_t riff_bytes = 0xFFFFFFFFu;
+    if (samples != MORSE_AUDIO_STREAMING && samples <= (0xFFFFFFFFu - 36u) / 2)
+    {
+        data_bytes = (uint32_t)(samples * 2);
+        riff_bytes = data_bytes + 36u;
+    }
+
+    unsigned rate = audio->config.sample_rate;
+    MEMORY_COPY(header, "RIFF", 4);
+    put_u32(header + 4, riff_bytes);
+    MEMORY_COPY(header + 8, "WAVEfmt ", 8);
+    put_u32(header + 16, 16);       // fmt chunk size
+    put_u16(header + 20, 1);        // PCM
+    put_u16(header + 22, 1);        // mono
+    put_u32(header + 24, rate);
+    put_u32(header + 28, rate * 2); // byte rate
+    put_u16(header + 32, 2);        // block align
+    put_u16(header + 34, 16);       // bits per sample
+    MEMORY_COPY(header + 36, "data", 4);
+    put_u32(header + 40, data_bytes);
+}
+
+#define SIGNAL_MIN 0.01  // magnitude below which there is no tone at all
+#define NOISE_RISE 0.002 // per block, how fast the floor follows a louder input
+
+bool morse_audio_decoder_init(MorseAudioDecoder* decoder, const MorseDecodeTable* table,
+                              unsigned sample_rate, double frequency)
+{
+    if (!table || sample_rate < 1000 || sample_rate > 384000) { return false; }
+    if (!(frequency > 0 && frequency < sample_rate / 2.0)) { return false; }
+
+    size_t block = seconds_to_samples(MORSE_AUDIO_DECODER_BLOCK_SECONDS, sample_rate);
+    *decoder = (MorseAudioDecoder){
+        .coefficient = 2.0 * cos(2.0 * AUDIO_PI * frequency / (double)sample_rate),
+        .block_samples = block > MORSE_AUDIO_DECODER_MIN_BLOCK ? block : MORSE_AUDIO_DECODER_MIN_BLOCK,
+        .low_byte = -1,
+        .noise = 1.0,
+        .decay = exp(-MORSE_AUDIO_DECODER_BLOCK_SECONDS / 5.0), // the peak halves in about 3.5 s
+    };
+    morse_timing_init(&decoder->timing, table);
+    return true;
+}
+
+// One finished block with tone magnitude `magnitude`
+static size_t decode_audio_block(MorseAudioDecoder* decoder, double magnitude, char* output)
+{
+    if (magnitude > decoder->signal) decoder->signal = magnitude;
+    else decoder->signal *= decoder->decay;
+    if (magnitude < decoder->noise) decoder->noise = magnitude;
+    else decoder->noise += (magnitude - decoder->noise) * NOISE_RISE;
+
+    double range = decoder->signal - decoder->noise;
+    double threshold = decoder->noise + range * (decoder->key_down ? 0.3 : 0.5);
+    decoder->key_down = decoder->signal > SIGNAL_MIN && magnitude > threshold;
+    return morse_timing_feed(&decoder->timing, decoder->key_down, 1.0, output);
+}
+
+size_t morse_audio_decoder_feed(MorseAudioDecoder* decoder, const void* pcm, size_t bytes, char* output)
+{
+    const unsigned char* data = pcm;
+    size_t len = 0;
+    size_t i = 0;
+    while (i < bytes)
+    {
+        // Samples are little-endian, a chunk may end between the two bytes of one
+        int16_t sample;
+        if (decoder->low_byte >= 0)
+        {
+            sample = (int16_t)(uint16_t)((unsigned)decoder->low_byte | (unsigned)data[i] << 8);
+            decoder->low_byte = -1;
+            i++;
+        } else if (i + 1 < bytes)
+        {
+            sample = (int16_t)(uint16_t)((unsigned)data[i] | (unsigned)data[i + 1] << 8);
+            i += 2;
+        } else
+        {
+            decoder->low_byte = data[i];
+            break;
+        }
+
+        double s0 = (double)sample / 32768.0 + decoder->coefficient * decoder->s1 - decoder->s2;
+        decoder->s2 = decoder->s1;
+        decoder->s1 = s0;
+        if (++decoder->filled < decoder->block_samples) continue;
+
+        double power = decoder->s1 * decoder->s1 + decoder->s2 * decoder->s2
+                     - decoder->coefficient * decoder->s1 * decoder->s2;
+        double magnitude = sqrt(power > 0 ? power : 0) * 2.0 / (double)decoder->block_samples;
+        len += decode_audio_block(decoder, magnitude, output + len);
+        decoder->filled = 0;
+        decoder->s1 = 0;
+        decoder->s2 = 0;
+    }
+    return len;
+}
+
+size_t morse_audio_decoder_finish(MorseAudioDecoder* decoder, char* output)
+{
+    // A mark still sounding at the end is counted as it stands
+    size_t len = morse_timing_finish(&decoder->timing, output);
+    decoder->key_down = false;
+    decoder->filled = 0;
+    decoder->s1 = 0;
+    decoder->s2 = 0;
+    decoder->low_byte = -1;
+    return len;
+}
@@ -0,0 +1,246 @@
+#define _GNU_SOURCE
+#include "morse-batch.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+
+#define BATCH_MAX_THREADS 256
+
+typedef struct BatchShared
+{
+    const char* const* paths;
+    MorseBatchMode mode;
+    const char* suffix;
+    const MorseEncodeTable* encode_table;
+    const MorseDecodeTable* decode_table;
+    struct BatchWorker* workers;
+    size_t worker_count;
+} BatchShared;
+
+typedef struct BatchWorker
+{
+    pthread_t thread;
+    pthread_mutex_t lock; // guards begin/end, thieves take from the back
+    size_t begin; // next path index this worker will take
+    size_t end;
+    size_t index; // position in shared->workers
+    BatchShared* shared;
+    char* output; // reused for every file
+    size_t output_capacity;
+    size_t failed;
+} BatchWorker;
+
+static bool take_own(BatchWorker* worker, size_t* path_index)
+{
+    pthread_mutex_lock(&worker->lock);
+    bool taken = worker->begin < worker->end;
+    if (taken) *path_index = worker->begin++;
+    pthread_mutex_unlock(&worker->lock);
+    return taken;
+}
+
+// Move the back half of the first non-empty victim's share into our own
+static bool steal(BatchWorker* thief, size_t* path_index)
+{
+    BatchShared* shared = thief->shared;
+    for (size_t step = 1; step < shared->worker_count; step++)
+    {
+        BatchWorker* victim = &shared->workers[(thief->index + step) % shared->worker_count];
+        pthread_mutex_lock(&victim->lock);
+        size_t remaining = victim->end - victim->begin;
+        size_t begin = victim->end - (remaining + 1) / 2;
+        size_t end = victim->end;
+        victim->end = begin;
+        pthread_mutex_unlock(&victim->lock);
+        if (remaining == 0) continue;
+
+        pthread_mutex_lock(&thief->lock);
+        thief->begin = begin + 1;
+        thief->end = end;
+        pthread_mutex_unlock(&thief->lock);
+        *path_index = begin;
+        return true;
+    }
+    return false;
+}
+
+static bool reserve_output(BatchWorker* worker, size_t size)
+{
+    if (worker->output_capacity >= size) return true;
+    char* output = realloc(worker->output, size);
+    if (!output) { return false; }
+    worker->output = output;
+    worker->output_capacity = size;
+    return true;
+}
+
+static bool write_all(int fd, const char* data, size_t length)
+{
+    while (length > 0)
+    {
+        ssize_t written = write(fd, data, length);
+        if (written < 0)
+        {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        data += written;
+        length -= (size_t)written;
+    }
+    return true;
+}
+
+// Translate `input` into the worker's buffer, returns false (with a message) when it cannot
+static bool translate(BatchWorker* worker, const char* path, const char* input, size_t length, size_t* written)
+{
+    const BatchShared* shared = worker->shared;
+    if (shared->mode == MORSE_BATCH_ENCODE)
+    {
+        size_t size = morse_encode_size_with_table(shared->encode_table, input, length);
+        if (!reserve_output(worker, size + 2))
+        {
+            fprintf(stderr, "%s: Memory allocation failed\n", path);
+            return false;
+        }
+        *written = morse_encode_into_with_table(shared->encode_table, input, length, worker->output, size + 1);
+        return true;
+    }
+
+    // Every output byte consumes at least one input byte
+    if (!reserve_output(worker, length + 2))
+    {
+        fprintf(stderr, "%s: Memory allocation failed\n", path);
+        return false;
+    }
+    MorseDecoder decoder;
+    morse_decoder_init_with_table(&decoder, shared->decode_table, MORSE_DECODE_STRICT);
+    if (!morse_decoder_feed(&decoder, input, length, worker->output, written))
+    {
+        fprintf(stderr, "%s: invalid character at offset %zu\n", path, decoder.error_offset);
+        return false;
+    }
+    *written += morse_decoder_finish(&decoder, worker->output + *written);
+    return true;
+}
+
+static bool process_file(BatchWorker* worker, const char* path)
+{
+    const BatchShared* shared = worker->shared;
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    struct stat info;
+    if (fd < 0 || fstat(fd, &info) != 0 || !S_ISREG(info.st_mode))
+    {
+        fprintf(stderr, "%s: %s\n", path, fd < 0 ? strerror(errno) : "not a regular file");
+        if (fd >= 0) close(fd);
+        return false;
+    }
+
+    size_t length = (size_t)info.st_size;
+    const char* input = "";
+    void* mapping = NULL;
+    if (length > 0)
+    {
+        mapping = mmap(NULL, length, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (mapping == MAP_FAILED)
+        {
+            fprintf(stderr, "%s: %s\n", path, strerror(errno));
+            close(fd);
+            return false;
+        }
+        madvise(mapping, length, MADV_SEQUENTIAL);
+        input = mapping;
+    }
+    close(fd);
+
+    while (length > 0 && (input[length - 1] == '\n' || input[length - 1] == '\r')) length--;
+
+    size_t written = 0;
+    bool translated = translate(worker, path, input, length, &written);
+    if (mapping) munmap(mapping, (size_t)info.st_size);
+    if (!translated) { return false; }
+    worker->output[written++] = '\n';
+
+    size_t path_len = strlen(path);
+    size_t suffix_len = strlen(shared->suffix);
+    char* output_path = malloc(path_len + suffix_len + 1);
+    if (!output_path)
+    {
+        fprintf(stderr, "%s: Memory allocation failed\n", path);
+        return false;
+    }
+    MEMORY_COPY(output_path, path, path_len);
+    MEMORY_COPY(output_path + path_len, shared->suffix, suffix_len + 1);
+
+    int out = open(output_path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    bool saved = out >= 0 && write_all(out, worker->output, written);
+    if (out >= 0 && close(out) != 0) saved = false;
+    if (!saved) fprintf(stderr, "%s: %s\n", output_path, strerror(errno));
+    free(output_path);
+    return saved;
+}
+
+static void* batch_worker(void* argument)
+{
+    BatchWorker* worker = argument;
+    size_t path_index;
+    while (take_own(worker, &path_index) || steal(worker, &path_index))
+    {
+        if (!process_file(worker, worker->shared->paths[path_index])) worker->failed++;
+    }
+    return NULL;
+}
+
+size_t morse_batch_run(const char* const* paths, size_t count, MorseBatchMode mode, const char* suffix,
+                       size_t threads, const MorseEncodeTable* encode_table, const MorseDecodeTable* decode_table)
+{
+    if (count == 0) { return 0; }
+    if (!paths || !encode_table || !decode_table) { return count; }
+    if (!suffix) suffix = mode == MORSE_BATCH_ENCODE ? MORSE_BATCH_ENCODE_SUFFIX : MORSE_BATCH_DECODE_SUFFIX;
+    if (threads > count) threads = count;
+    if (threads > BATCH_MAX_THREADS) threads = BATCH_MAX_THREADS;
+    if (threads == 0) threads = 1;
+
+    BatchWorker* workers = calloc(threads, sizeof(BatchWorker));
+    if (!workers)
+    {
+        fprintf(stderr, "Memory allocation failed\n");
+        return count;
+    }
+    BatchShared shared = { paths, mode, suffix, encode_table, decode_table, workers, threads };
+
+    for (size_t i = 0; i < threads; i++)
+    {
+        workers[i].begin = count / threads * i;
+        workers[i].end = i + 1 < threads ? count / threads * (i + 1) : count;
+        workers[i].index = i;
+        workers[i].shared = &shared;
+        pthread_mutex_init(&workers[i].lock, NULL);
+    }
+
+    // Worker 0 runs on the calling thread; a worker that fails to start has its share stolen
+    bool* started = calloc(threads, sizeof(bool));
+    for (size_t i = 1; i < threads && started; i++)
+    {
+        started[i] = pthread_create(&workers[i].thread, NULL, batch_worker, &workers[i]) == 0;
+    }
+    batch_worker(&workers[0]);
+
+    size_t failed = 0;
+    for (size_t i = 0; i < threads; i++)
+    {
+        if (started && started[i]) pthread_join(workers[i].thread, NULL);
+        failed += workers[i].failed;
+        free(workers[i].output);
+        pthread_mutex_destroy(&workers[i].lock);
+    }
+    free(started);
+    free(workers);
+    return failed;
+}
@@ -0,0 +1,381 @@
+#include "morse-cache.h"
+#include "memory-copy.h"
+#include "morse-stats.h"
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+
+#define CACHE_MAX_ENTRIES (1u << 24)
+#define CACHE_SECRET0 0xa0761d6478bd642full // wyhash constants
+#define CACHE_SECRET1 0xe7037ed1a0b428dbull
+
+// Keys are zero-padded to whole 16-byte blocks, so they are hashed and compared a block at a time
+#define CACHE_BLOCK 16
+#define CACHE_PADDED(length) (((length) + CACHE_BLOCK - 1) & ~(size_t)(CACHE_BLOCK - 1))
+
+// 64x64 -> 128-bit multiply, folded to 64 bits
+static inline uint64_t cache_mum(uint64_t a, uint64_t b)
+{
+#ifdef __SIZEOF_INT128__
+    __extension__ unsigned __int128 product = (unsigned __int128)a * b;
+    return (uint64_t)product ^ (uint64_t)(product >> 64);
+#else
+    uint64_t ha = a >> 32, la = (uint32_t)a, hb = b >> 32, lb = (uint32_t)b;
+    uint64_t hh = ha * hb, hl = ha * lb, lh = la * hb, ll = la * lb;
+    uint64_t mid = (ll >> 32) + (uint32_t)hl + (uint32_t)lh;
+    uint64_t lo = (uint32_t)ll | mid << 32;
+    uint64_t hi = hh + (hl >> 32) + (lh >> 32) + (mid >> 32);
+    return lo ^ hi;
+#endif
+}
+
+static inline uint64_t read64(const unsigned char* p)
+{
+    uint64_t value;
+    MEMORY_COPY(&value, p, sizeof(value));
+    return value;
+}
+
+// wyhash-style: one multiply per 16-byte block of the padded key
+static inline uint64_t cache_hash(const char* key, size_t length)
+{
+    const unsigned char* p = (const unsigned char*)key;
+    uint64_t seed = CACHE_SECRET0 ^ length;
+    for (size_t i = 0; i < CACHE_PADDED(length); i += CACHE_BLOCK)
+    {
+        seed = cache_mum(read64(p + i) ^ CACHE_SECRET1, read64(p + i + 8) ^ seed);
+    }
+    return seed;
+}
+
+static inline bool cache_key_equal(const char* stored, const char* key, size_t length)
+{
+    const unsigned char* a = (const unsigned char*)stored;
+    const unsigned char* b = (const unsigned char*)key;
+    for (size_t i = 0; i < CACHE_PADDED(length); i += 8)
+    {
+        if (read64(a + i) != read64(b + i)) return false;
+    }
+    return true;
+}
+
+// Slots of `key_max` + `value_max` bytes, as many as a power of two fits in `budget`
+static bool word_cache_init(MorseWordCache* cache, size_t key_max, size_t value_max, size_t budget)
+{
+    assert(key_max % CACHE_BLOCK == 0 && value_max % CACHE_BLOCK == 0);
+    *cache = (MorseWordCache){ .key_max = key_max, .slot_size = key_max + value_max };
+    size_t per_entry = sizeof(MorseCacheEntry) + 2 * sizeof(uint32_t) + cache->slot_size;
+    size_t capacity = MORSE_CACHE_MIN_ENTRIES;
+    if (budget / per_entry < capacity) { return false; }
+    while (capacity < CACHE_MAX_ENTRIES && capacity * 2 <= budget / per_entry) capacity *= 2;
+
+    size_t bytes = capacity * per_entry;
+    char* block = malloc(bytes);
+    MORSE_STATS_MALLOC(block, bytes);
+    if (!block) { return false; }
+    cache->entries = (MorseCacheEntry*)block;
+    cache->index = (uint32_t*)(block + capacity * sizeof(MorseCacheEntry));
+    cache->slab = block + capacity * (sizeof(MorseCacheEntry) + 2 * sizeof(uint32_t));
+    cache->capacity = capacity;
+    memset(block, 0, bytes); // the index empty, and no slot padding left undefined
+
+    return true;
+}
+
+static void word_cache_delete(MorseWordCache* cache)
+{
+    MORSE_STATS_FREE(cache->entries);
+    free(cache->entries);
+    cache->entries = NULL;
+    cache->index = NULL;
+    cache->slab = NULL;
+    cache->capacity = 0;
+    cache->used = 0;
+}
+
+static void word_cache_clear(MorseWordCache* cache)
+{
+    if (cache->index) memset(cache->index, 0, 2 * cache->capacity * sizeof(uint32_t));
+    cache->used = 0;
+    cache->hand = 0;
+    cache->stats = (MorseCacheStats){ 0 };
+}
+
+// The cached value of `key`, zero-padded to CACHE_PADDED(key_length) bytes, or NULL
+static const char* word_cache_get(MorseWordCache* cache, uint64_t hash, const char* key, size_t key_length,
+                                  size_t* value_length)
+{
+    size_t mask = 2 * cache->capacity - 1;
+    for (size_t slot = hash & mask; cache->index[slot] != 0; slot = (slot + 1) & mask)
+    {
+        size_t e = cache->index[slot] - 1;
+        MorseCacheEntry* entry = &cache->entries[e];
+        const char* stored = cache->slab + e * cache->slot_size;
+        if (entry->hash == hash && entry->key_length == key_length && cache_key_equal(stored, key, key_length))
+        {
+            entry->referenced = true;
+            cache->stats.hits++;
+            *value_length = entry->value_length;
+            return stored + cache->key_max;
+        }
+    }
+    cache->stats.misses++;
+    return NULL;
+}
+
+// Take entry `e` out of the index; later entries of its probe run move back into the hole
+static void word_cache_unlink(MorseWordCache* cache, size_t e)
+{
+    size_t mask = 2 * cache->capacity - 1;
+    size_t hole = cache->entries[e].hash & mask;
+    while (cache->index[hole] != e + 1) hole = (hole + 1) & mask;
+
+    for (size_t slot = (hole + 1) & mask; cache->index[slot] != 0; slot = (slot + 1) & mask)
+    {
+        size_t home = cache->entries[cache->index[slot] - 1].hash & mask;
+        // Only an entry whose probe passed through the hole may fill it
+        if (((slot - home) & mask) >= ((slot - hole) & mask))
+        {
+            cache->index[hole] = cache->index[slot];
+            hole = slot;
+        }
+    }
+    cache->index[hole] = 0;
+}
+
+// CLOCK: the first entry not hit since the hand last passed it
+static size_t word_cache_victim(MorseWordCache* cache)
+{
+    for (;;)
+    {
+        size_t e = cache->hand;
+        cache->hand = (cache->hand + 1) & (cache->capacity - 1);
+        if (!cache->entries[e].referenced) return e;
+        cache->entries[e].referenced = false;
+    }
+}
+
+// Insert a (padded) key word_cache_get just missed; `value_length` fits the slot
+static void word_cache_put(MorseWordCache* cache, uint64_t hash, const char* key, size_t key_length,
+                           const char* value, size_t value_length)
+{
+    size_t e;
+    if (cache->used < cache->capacity) e = cache->used++;
+    else
+    {
+        e = word_cache_victim(cache);
+        word_cache_unlink(cache, e);
+        cache->stats.evictions++;
+    }
+    cache->entries[e] = (MorseCacheEntry){ hash, (uint16_t)key_length, (uint16_t)value_length, false };
+    char* stored = cache->slab + e * cache->slot_size;
+    MEMORY_COPY(stored, key, CACHE_PADDED(key_length));
+    MEMORY_COPY(stored + cache->key_max, value, value_length);
+
+    size_t mask = 2 * cache->capacity - 1;
+    size_t slot = hash & mask;
+    while (cache->index[slot] != 0) slot = (slot + 1) & mask;
+    cache->index[slot] = (uint32_t)(e + 1);
+}
+
+bool morse_encode_cache_init(MorseEncodeCache* cache, const MorseEncodeTable* table, size_t budget)
+{
+    cache->table = table;
+    cache->words = (MorseWordCache){ 0 };
+    if (!table) { return false; }
+    // A character writes at most its code and a space; a multiple of CACHE_BLOCK
+    size_t value_max = MORSE_ENCODE_CACHE_WORD_MAX * (MORSE_CODE_MAX_LENGTH + 1);
+    return word_cache_init(&cache->words, MORSE_ENCODE_CACHE_WORD_MAX, value_max, budget);
+}
+
+void morse_encode_cache_delete(MorseEncodeCache* cache)
+{
+    word_cache_delete(&cache->words);
+}
+
+void morse_encode_cache_clear(MorseEncodeCache* cache)
+{
+    word_cache_clear(&cache->words);
+}
+
+// `word` is zero-padded to the slot's key size
+static size_t encode_word(MorseEncodeCache* cache, const char* word, size_t length, char* output)
+{
+    MorseWordCache* words = &cache->words;
+    uint64_t hash = cache_hash(word, length);
+    size_t len;
+    const char* cached = word_cache_get(words, hash, word, length, &len);
+    if (cached)
+    {
+        // Whole blocks: value slots are padded, and the caller leaves MORSE_CACHE_OUTPUT_SLACK
+        for (size_t o = 0; o < len; o += CACHE_BLOCK) MEMORY_COPY(output + o, cached + o, CACHE_BLOCK);
+        return len;
+    }
+    len = morse_encode_chars(cache->table, word, length, output);
+    word_cache_put(words, hash, word, length, output, len);
+    return len;
+}
+
+size_t morse_encode_cache_span(MorseEncodeCache* cache, const char* text_message, size_t length, char* output)
+{
+    char word[MORSE_ENCODE_CACHE_WORD_MAX];
+    size_t len = 0;
+    size_t i = 0;
+    while (i < length)
+    {
+        // A word is cached with the space after it, if any, so most take one lookup
+        size_t start = i;
+        memset(word, 0, sizeof(word));
+        bool ended = false;
+        while (i < length && i - start < sizeof(word) && !ended)
+        {
+            word[i - start] = text_message[i];
+            ended = text_message[i++] == ' ';
+        }
+        if (!ended && i < length && i - start == sizeof(word))
+        {
+            while (i < length && text_message[i++] != ' ') {}
+            cache->words.stats.bypasses++;
+            len += morse_encode_chars(cache->table, text_message + start, i - start, output + len);
+            continue;
+        }
+        len += encode_word(cache, word, i - start, output + len);
+    }
+    MORSE_STATS_CALL(encode_calls, length, len);
+    return len;
+}
+
+char* morse_encode_cached(MorseEncodeCache* cache, const char* text_message, size_t length)
+{
+    if (!cache || !text_message) { return NULL; }
+
+    size_t size = morse_encoded_length(cache->table, text_message, length);
+    char* output = malloc(size + MORSE_CACHE_OUTPUT_SLACK);
+    MORSE_STATS_MALLOC(output, size + MORSE_CACHE_OUTPUT_SLACK);
+    if (!output)
+    {
+        fprintf(stderr, "Memory allocation failed\n");
+        return NULL;
+    }
+    size_t len = morse_encode_cache_span(cache, text_message, length, output);
+    // Letters and word gaps end in a space, which the last one drops; only '?' does not
+    if (len > 0 && output[len - 1] == ' ') len--;
+    output[len] = '\0';
+    return output;
+}
+
+bool morse_decode_cache_init(MorseDecodeCache* cache, const MorseDecodeTable* table, size_t budget)
+{
+    cache->table = table;
+    cache->words = (MorseWordCache){ 0 };
+    if (!table) { return false; }
+    // Every output byte consumes at least one input byte
+    return word_cache_init(&cache->words, MORSE_DECODE_CACHE_WORD_MAX, MORSE_DECODE_CACHE_WORD_MAX, budget);
+}
+
+void morse_decode_cache_delete(MorseDecodeCache* cache)
+{
+    word_cache_delete(&cache->words);
+}
+
+void morse_decode_cache_clear(MorseDecodeCache* cache)
+{
+    word_cache_clear(&cache->words);
+}
+
+// `word` is zero-padded to the slot's key size; returns the bytes written, or SIZE_MAX
+// with `invalid_offset` set when strict decoding stops in it
+static size_t decode_word(MorseDecodeCache* cache, const char* word, size_t length, MorseDecodeMode mode,
+                          char* output, size_t* invalid_offset)
+{
+    MorseWordCache* words = &cache->words;
+    uint64_t hash = cache_hash(word, length);
+    size_t len;
+    const char* cached = word_cache_get(words, hash, word, length, &len);
+    if (cached)
+    {
+        for (size_t o = 0; o < len; o += CACHE_BLOCK) MEMORY_COPY(output + o, cached + o, CACHE_BLOCK);
+        *invalid_offset = MORSE_DECODE_NO_ERROR;
+        return len;
+    }
+
+    len = morse_decode_chars(cache->table, word, length, mode, output, invalid_offset);
+    if (*invalid_offset == MORSE_DECODE_NO_ERROR) word_cache_put(words, hash, word, length, output, len);
+    else if (mode == MORSE_DECODE_STRICT) return SIZE_MAX;
+    return len;
+}
+
+char* morse_decode_cached(MorseDecodeCache* cache, const char* morse_message, size_t message_len,
+                          MorseDecodeMode mode, size_t* error_offset)
+{
+    if (error_offset) *error_offset = MORSE_DECODE_NO_ERROR;
+    if (!cache || !morse_message) { return NULL; }
+
+    char* output = malloc(message_len + MORSE_CACHE_OUTPUT_SLACK);
+    MORSE_STATS_MALLOC(output, message_len + MORSE_CACHE_OUTPUT_SLACK);
+    if (!output)
+    {
+        fprintf(stderr, "Memory allocation failed\n");
+        return NULL;
+    }
+
+    char word[MORSE_DECODE_CACHE_WORD_MAX];
+    size_t first_invalid = MORSE_DECODE_NO_ERROR;
+    size_t len = 0;
+    size_t i = 0;
+    while (i < message_len)
+    {
+        // Copy the word aside while looking for its end: a '/' and any spaces after it
+        size_t start = i;
+        memset(word, 0, sizeof(word));
+        bool slash = false;
+        while (i < message_len && i - start < sizeof(word) && !(slash && morse_message[i] != ' '))
+        {
+            word[i - start] = morse_message[i];
+            if (morse_message[i++] == '/') slash = true;
+        }
+
+        size_t invalid;
+        size_t written;
+        if (i < message_len && !(slash && morse_message[i] != ' '))
+        {
+            if (!slash)
+            {
+                while (i < message_len && morse_message[i] != '/') i++;
+                if (i < message_len) i++;
+            }
+            while (i < message_len && morse_message[i] == ' ') i++;
+            cache->words.stats.bypasses++;
+            written = morse_decode_chars(cache->table, morse_message + start, i - start, mode, output + len, &invalid);
+            if (invalid != MORSE_DECODE_NO_ERROR && mode == MORSE_DECODE_STRICT) written = SIZE_MAX;
+        } else
+        {
+            written = decode_word(cache, word, i - start, mode, output + len, &invalid);
+            // The miss is counted, but a word with invalid bytes is not cached
+            if (invalid != MORSE_DECODE_NO_ERROR) cache->words.stats.bypasses++;
+        }
+        if (invalid != MORSE_DECODE_NO_ERROR && first_invalid == MORSE_DECODE_NO_ERROR) first_invalid = start + invalid;
+        if (written == SIZE_MAX)
+        {
+            if (error_offset) *error_offset = first_invalid;
+            MORSE_STATS_FREE(output);
+            free(output);
+            return NULL;
+        }
+        len += written;
+    }
+
+    // As the decoder ends a message: a final '/' writes no space, and one trailing space is dropped
+    size_t trim = message_len > 0 && morse_message[message_len - 1] == '/' ? 2 : 1;
+    while (trim > 0 && len > 0 && output[len - 1] == ' ')
+    {
+        len--;
+        trim--;
+    }
+    output[len] = '\0';
+    if (error_offset) *error_offset = first_invalid;
+    MORSE_STATS_CALL(decode_calls, message_len, len);
+    return output;
+}
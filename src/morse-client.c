@@ -0,0 +1,124 @@
+#define _GNU_SOURCE
+#include "morse-server.h"
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+
+bool morse_client_connect(MorseClient* client, const char* socket_path)
+{
+    client->fd = -1;
+    client->start = 0;
+    client->end = 0;
+
+    struct sockaddr_un address = { .sun_family = AF_UNIX };
+    if (strlen(socket_path) >= sizeof(address.sun_path)) { return false; }
+    strcpy(address.sun_path, socket_path);
+
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0) { return false; }
+    if (connect(fd, (struct sockaddr*)&address, sizeof(address)) != 0)
+    {
+        close(fd);
+        return false;
+    }
+    client->fd = fd;
+    return true;
+}
+
+static bool send_all(int fd, const char* data, size_t length)
+{
+    while (length > 0)
+    {
+        ssize_t sent = send(fd, data, length, MSG_NOSIGNAL);
+        if (sent < 0)
+        {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        data += sent;
+        length -= (size_t)sent;
+    }
+    return true;
+}
+
+bool morse_client_send(MorseClient* client, char operation, const char* payload, size_t length)
+{
+    if (length > MORSE_SERVER_MAX_PAYLOAD) { return false; }
+
+    // Small requests go out in one write
+    char frame[4096];
+    frame[0] = operation;
+    frame[1] = (char)(length >> 24);
+    frame[2] = (char)(length >> 16);
+    frame[3] = (char)(length >> 8);
+    frame[4] = (char)length;
+    if (length <= sizeof(frame) - MORSE_FRAME_HEADER_SIZE)
+    {
+        MEMORY_COPY(frame + MORSE_FRAME_HEADER_SIZE, payload, length);
+        return send_all(client->fd, frame, MORSE_FRAME_HEADER_SIZE + length);
+    }
+    return send_all(client->fd, frame, MORSE_FRAME_HEADER_SIZE) && send_all(client->fd, payload, length);
+}
+
+// Copy `length` bytes from the connection, refilling the buffer as needed
+static bool client_read(MorseClient* client, char* destination, size_t length)
+{
+    while (length > 0)
+    {
+        if (client->start == client->end)
+        {
+            ssize_t got = read(client->fd, client->buffer, sizeof(client->buffer));
+            if (got < 0 && errno == EINTR) continue;
+            if (got <= 0) { return false; }
+            client->start = 0;
+            client->end = (size_t)got;
+        }
+        size_t available = client->end - client->start;
+        size_t take = available < length ? available : length;
+        MEMORY_COPY(destination, client->buffer + client->start, take);
+        client->start += take;
+        destination += take;
+        length -= take;
+    }
+    return true;
+}
+
+bool morse_client_receive(MorseClient* client, MorseResponse* response)
+{
+    char header[MORSE_FRAME_HEADER_SIZE];
+    if (!client_read(client, header, sizeof(header))) { return false; }
+
+    const unsigned char* u = (const unsigned char*)header;
+    size_t length = (size_t)u[1] << 24 | (size_t)u[2] << 16 | (size_t)u[3] << 8 | (size_t)u[4];
+    if (length > MORSE_SERVER_MAX_PAYLOAD) { return false; }
+
+    if (response->capacity < length + 1)
+    {
+        char* payload = realloc(response->payload, length + 1);
+        if (!payload) { return false; }
+        response->payload = payload;
+        response->capacity = length + 1;
+    }
+    if (!client_read(client, response->payload, length)) { return false; }
+    response->payload[length] = '\0';
+    response->status = u[0];
+    response->length = length;
+    return true;
+}
+
+void morse_client_close(MorseClient* client)
+{
+    if (client->fd >= 0) close(client->fd);
+    client->fd = -1;
+}
+
+void morse_response_free(MorseResponse* response)
+{
+    free(response->payload);
+    *response = (MorseResponse){ 0, NULL, 0, 0 };
+}
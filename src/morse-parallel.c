@@ -0,0 +1,314 @@
+#include "morse-parallel.h"
+#include "morse-stats.h"
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+
+// Workers are started on first use and then kept for the life of the process, parked on a
+// condition variable between calls. One call runs at a time; task 0 of every call runs on the
+// calling thread, task i on worker i - 1.
+typedef void (*PoolTask)(void* item);
+
+static struct
+{
+    pthread_mutex_t run_lock;  // held by the call using the pool
+    pthread_mutex_t lock;      // guards the fields below
+    pthread_cond_t work;
+    pthread_cond_t done;
+    size_t started;            // workers running
+    unsigned long generation;  // bumped for every call
+    PoolTask task;
+    char* items;
+    size_t stride;
+    size_t workers;            // workers given an item this call
+    size_t pending;            // of those, still running
+} pool = { PTHREAD_MUTEX_INITIALIZER, PTHREAD_MUTEX_INITIALIZER, PTHREAD_COND_INITIALIZER,
+           PTHREAD_COND_INITIALIZER, 0, 0, NULL, NULL, 0, 0, 0 };
+
+static void* pool_worker(void* argument)
+{
+    size_t id = (size_t)(uintptr_t)argument;
+    unsigned long seen = 0;
+    pthread_mutex_lock(&pool.lock);
+    for (;;)
+    {
+        while (pool.generation == seen) pthread_cond_wait(&pool.work, &pool.lock);
+        seen = pool.generation;
+        if (id >= pool.workers) continue;
+
+        PoolTask task = pool.task;
+        void* item = pool.items + (id + 1) * pool.stride;
+        pthread_mutex_unlock(&pool.lock);
+        task(item);
+        pthread_mutex_lock(&pool.lock);
+        if (--pool.pending == 0) pthread_cond_signal(&pool.done);
+    }
+    return NULL;
+}
+
+// Run task over `count` items of `stride` bytes and wait for all of them. Items the pool has
+// no worker for (thread creation failed) run on the calling thread.
+static void pool_run(PoolTask task, void* items, size_t stride, size_t count)
+{
+    pthread_mutex_lock(&pool.run_lock);
+    while (pool.started + 1 < count)
+    {
+        pthread_t thread;
+        if (pthread_create(&thread, NULL, pool_worker, (void*)(uintptr_t)pool.started) != 0) break;
+        pthread_detach(thread);
+        pool.started++;
+    }
+    size_t workers = count - 1 < pool.started ? count - 1 : pool.started;
+
+    pthread_mutex_lock(&pool.lock);
+    pool.task = task;
+    pool.items = items;
+    pool.stride = stride;
+    pool.workers = workers;
+    pool.pending = workers;
+    pool.generation++;
+    pthread_cond_broadcast(&pool.work);
+    pthread_mutex_unlock(&pool.lock);
+
+    task(items);
+    for (size_t i = workers + 1; i < count; i++) task((char*)items + i * stride);
+
+    pthread_mutex_lock(&pool.lock);
+    while (pool.pending > 0) pthread_cond_wait(&pool.done, &pool.lock);
+    pthread_mutex_unlock(&pool.lock);
+    pthread_mutex_unlock(&pool.run_lock);
+}
+
+
+typedef struct DecodeChunk
+{
+    const MorseDecodeTable* table;
+    MorseDecodeMode mode;
+    const char* input; // chunk start
+    size_t offset; // of the chunk within the message
+    size_t length;
+    char* output;
+    size_t written;
+    size_t error_offset;
+    bool failed; // strict decoding stopped, or out of memory
+} DecodeChunk;
+
+static void decode_chunk(void* argument)
+{
+    DecodeChunk* chunk = argument;
+    size_t size = MORSE_DECODER_FEED_BOUND(chunk->length) + MORSE_DECODER_FINISH_BOUND;
+    chunk->output = malloc(size);
+    MORSE_STATS_MALLOC(chunk->output, size);
+    if (!chunk->output)
+    {
+        chunk->failed = true;
+        return;
+    }
+
+    MorseDecoder decoder;
+    morse_decoder_init_with_table(&decoder, chunk->table, chunk->mode);
+    decoder.consumed = chunk->offset; // report error offsets within the whole message
+
+    size_t len = 0;
+    bool decoded = morse_decoder_feed(&decoder, chunk->input, chunk->length, chunk->output, &len);
+    chunk->error_offset = decoder.error_offset;
+    if (!decoded)
+    {
+        chunk->failed = true;
+        return;
+    }
+
+    // Write out everything held back; the end-of-message rules are applied after joining
+    if (decoder.token.in_token)
+    {
+        len += morse_decoder_finish(&decoder, chunk->output + len);
+    } else
+    {
+        memset(chunk->output + len, ' ', decoder.held_spaces);
+        len += decoder.held_spaces;
+    }
+    chunk->written = len;
+}
+
+// Decode chunks split at '/' on worker threads and join their outputs in order
+char* morse_decode_parallel(const BTreeNode* root, const char* morse_message, size_t message_len, size_t threads,
+                            MorseDecodeMode mode, size_t* error_offset)
+{
+    if (error_offset) *error_offset = MORSE_DECODE_NO_ERROR;
+    if (!root || !morse_message) { return NULL; }
+
+    MorseDecodeTable table;
+    morse_decode_table_build(root, &table);
+    return morse_decode_parallel_with_table(&table, morse_message, message_len, threads, mode, error_offset);
+}
+
+char* morse_decode_parallel_with_table(const MorseDecodeTable* table, const char* morse_message, size_t message_len,
+                                       size_t threads, MorseDecodeMode mode, size_t* error_offset)
+{
+    if (error_offset) *error_offset = MORSE_DECODE_NO_ERROR;
+    if (!table || !morse_message) { return NULL; }
+
+    size_t useful_threads = message_len / MORSE_PARALLEL_MIN_CHUNK;
+    if (threads > useful_threads) threads = useful_threads;
+    if (threads > MORSE_PARALLEL_MAX_THREADS) threads = MORSE_PARALLEL_MAX_THREADS;
+    if (threads <= 1) { return morse_decode_checked_with_table(table, morse_message, message_len, mode, error_offset); }
+
+    DecodeChunk* chunks = calloc(threads, sizeof(DecodeChunk));
+    MORSE_STATS_MALLOC(chunks, threads * sizeof(DecodeChunk));
+    if (!chunks)
+    {
+        fprintf(stderr, "Memory allocation failed\n");
+        return NULL;
+    }
+
+    // Split just after the first '/' at or beyond each even share of the input
+    size_t count = 0;
+    size_t start = 0;
+    while (start < message_len && count < threads)
+    {
+        size_t end = message_len;
+        if (count + 1 < threads)
+        {
+            size_t target = message_len / threads * (count + 1);
+            if (target < start) target = start;
+            const char* slash = memchr(morse_message + target, '/', message_len - target);
+            if (slash) end = (size_t)(slash - morse_message) + 1;
+        }
+        chunks[count] = (DecodeChunk){ table, mode, morse_message + start, start, end - start,
+                                       NULL, 0, MORSE_DECODE_NO_ERROR, false };
+        count++;
+        start = end;
+    }
+
+    pool_run(decode_chunk, chunks, sizeof(DecodeChunk), count);
+
+    size_t first_error = MORSE_DECODE_NO_ERROR;
+    size_t total = 0;
+    bool failed = false;
+    for (size_t i = 0; i < count; i++)
+    {
+        if (chunks[i].error_offset < first_error) first_error = chunks[i].error_offset;
+        failed = failed || chunks[i].failed;
+        total += chunks[i].written;
+    }
+    if (error_offset) *error_offset = first_error;
+
+    char* output = failed ? NULL : malloc(total + 1);
+    MORSE_STATS_MALLOC(output, total + 1);
+    if (output)
+    {
+        size_t len = 0;
+        for (size_t i = 0; i < count; i++)
+        {
+            MEMORY_COPY(output + len, chunks[i].output, chunks[i].written);
+            len += chunks[i].written;
+        }
+        // A '/' ending the message writes no space, then one trailing space is trimmed
+        if (morse_message[message_len - 1] == '/' && len > 0 && output[len - 1] == ' ') len--;
+        if (len > 0 && output[len - 1] == ' ') len--;
+        output[len] = '\0';
+    } else if (!failed)
+    {
+        fprintf(stderr, "Memory allocation failed\n");
+    }
+
+    for (size_t i = 0; i < count; i++)
+    {
+        MORSE_STATS_FREE(chunks[i].output);
+        free(chunks[i].output);
+    }
+    MORSE_STATS_FREE(chunks);
+    free(chunks);
+    return output;
+}
+
+
+typedef struct EncodeSlice
+{
+    const MorseEncodeTable* table;
+    const char* input;
+    size_t length;
+    char* output; // start of this slice's part of the shared buffer
+    size_t output_length;
+} EncodeSlice;
+
+static void measure_slice(void* argument)
+{
+    EncodeSlice* slice = argument;
+    slice->output_length = morse_encoded_length(slice->table, slice->input, slice->length);
+}
+
+static void encode_slice(void* argument)
+{
+    EncodeSlice* slice = argument;
+    morse_encode_span(slice->table, slice->input, slice->length, slice->output);
+}
+
+// Size every slice in parallel, prefix-sum the sizes, then let every thread
+// write its slice straight into one exactly-sized buffer
+char* morse_encode_parallel(const BTreeNode* root, const char* text_message, size_t message_len, size_t threads)
+{
+    if (!root || !text_message) { return NULL; }
+
+    MorseEncodeTable table;
+    morse_encode_table_build(root, &table);
+    return morse_encode_parallel_with_table(&table, text_message, message_len, threads);
+}
+
+char* morse_encode_parallel_with_table(const MorseEncodeTable* table, const char* text_message, size_t message_len,
+                                       size_t threads)
+{
+    if (!table || !text_message) { return NULL; }
+
+    size_t useful_threads = message_len / MORSE_PARALLEL_MIN_CHUNK;
+    if (threads > useful_threads) threads = useful_threads;
+    if (threads > MORSE_PARALLEL_MAX_THREADS) threads = MORSE_PARALLEL_MAX_THREADS;
+    if (threads <= 1) { return morse_encode_n_with_table(table, text_message, message_len); }
+
+    EncodeSlice* slices = calloc(threads, sizeof(EncodeSlice));
+    MORSE_STATS_MALLOC(slices, threads * sizeof(EncodeSlice));
+    if (!slices)
+    {
+        fprintf(stderr, "Memory allocation failed\n");
+        return NULL;
+    }
+
+    // Characters encode independently, so any split point works
+    for (size_t i = 0; i < threads; i++)
+    {
+        size_t start = message_len / threads * i;
+        size_t end = i + 1 < threads ? message_len / threads * (i + 1) : message_len;
+        slices[i] = (EncodeSlice){ table, text_message + start, end - start, NULL, 0 };
+    }
+    pool_run(measure_slice, slices, sizeof(EncodeSlice), threads);
+
+    size_t total = 0;
+    for (size_t i = 0; i < threads; i++) total += slices[i].output_length;
+
+    char* output = malloc(total + 1);
+    MORSE_STATS_MALLOC(output, total + 1);
+    if (output)
+    {
+        size_t offset = 0;
+        for (size_t i = 0; i < threads; i++)
+        {
+            slices[i].output = output + offset;
+            offset += slices[i].output_length;
+        }
+        pool_run(encode_slice, slices, sizeof(EncodeSlice), threads);
+
+        // Remove trailing space if exists
+        if (total > 0 && output[total - 1] == ' ') total--;
+        output[total] = '\0';
+    } else
+    {
+        fprintf(stderr, "Memory allocation failed\n");
+    }
+
+    MORSE_STATS_FREE(slices);
+    free(slices);
+    return output;
+}
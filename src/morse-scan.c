@@ -0,0 +1,94 @@
+#include "morse-scan.h"
+
+#if defined(__x86_64__)
+#include <immintrin.h>
+#define MORSE_SCAN_X86 1
+#endif
+
+
+void morse_classify_scalar(const char* block, MorseBlockMasks* masks)
+{
+    uint64_t dot = 0, dash = 0, space = 0, slash = 0;
+    for (size_t i = 0; i < MORSE_SCAN_BLOCK; i++)
+    {
+        char ch = block[i];
+        dot |= (uint64_t)(ch == '.') << i;
+        dash |= (uint64_t)(ch == '-') << i;
+        space |= (uint64_t)(ch == ' ') << i;
+        slash |= (uint64_t)(ch == '/') << i;
+    }
+    masks->dot = dot;
+    masks->dash = dash;
+    masks->space = space;
+    masks->slash = slash;
+}
+
+#ifdef MORSE_SCAN_X86
+
+// SSE2 is part of the x86-64 baseline, so no target attribute is needed
+void morse_classify_sse2(const char* block, MorseBlockMasks* masks)
+{
+    const __m128i dot = _mm_set1_epi8('.');
+    const __m128i dash = _mm_set1_epi8('-');
+    const __m128i space = _mm_set1_epi8(' ');
+    const __m128i slash = _mm_set1_epi8('/');
+
+    MorseBlockMasks result = { 0, 0, 0, 0 };
+    for (size_t i = 0; i < MORSE_SCAN_BLOCK; i += 16)
+    {
+        __m128i bytes = _mm_loadu_si128((const __m128i*)(const void*)(block + i));
+        result.dot |= (uint64_t)(uint16_t)_mm_movemask_epi8(_mm_cmpeq_epi8(bytes, dot)) << i;
+        result.dash |= (uint64_t)(uint16_t)_mm_movemask_epi8(_mm_cmpeq_epi8(bytes, dash)) << i;
+        result.space |= (uint64_t)(uint16_t)_mm_movemask_epi8(_mm_cmpeq_epi8(bytes, space)) << i;
+        result.slash |= (uint64_t)(uint16_t)_mm_movemask_epi8(_mm_cmpeq_epi8(bytes, slash)) << i;
+    }
+    *masks = result;
+}
+
+__attribute__((target("avx2")))
+void morse_classify_avx2(const char* block, MorseBlockMasks* masks)
+{
+    const __m256i dot = _mm256_set1_epi8('.');
+    const __m256i dash = _mm256_set1_epi8('-');
+    const __m256i space = _mm256_set1_epi8(' ');
+    const __m256i slash = _mm256_set1_epi8('/');
+
+    __m256i low = _mm256_loadu_si256((const __m256i*)(const void*)block);
+    __m256i high = _mm256_loadu_si256((const __m256i*)(const void*)(block + 32));
+
+#define MOVEMASK64(needle) \
+    ((uint64_t)(uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(low, needle)) | \
+     (uint64_t)(uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(high, needle)) << 32)
+
+    masks->dot = MOVEMASK64(dot);
+    masks->dash = MOVEMASK64(dash);
+    masks->space = MOVEMASK64(space);
+    masks->slash = MOVEMASK64(slash);
+
+#undef MOVEMASK64
+}
+
+#endif // MORSE_SCAN_X86
+
+// Pick the widest classifier the running CPU supports
+MorseClassifyFn morse_classify_select(void)
+{
+#if defined(MORSE_SCAN_X86) && (defined(__GNUC__) || defined(__clang__))
+    if (__builtin_cpu_supports("avx2")) return morse_classify_avx2;
+    return morse_classify_sse2;
+#elif defined(MORSE_SCAN_X86)
+    return morse_classify_sse2;
+#else
+    return morse_classify_scalar;
+#endif
+}
+
+const char* morse_classify_name(MorseClassifyFn classify)
+{
+#ifdef MORSE_SCAN_X86
+    if (classify == morse_classify_avx2) return "avx2";
+    if (classify == morse_classify_sse2) return "sse2";
+#endif
+    if (classify == morse_classify_scalar) return "scalar";
+    return "unknown";
+}
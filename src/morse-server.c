@@ -0,0 +1,383 @@
+#define _GNU_SOURCE
+#include "morse-server.h"
+#include <errno.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+
+#define SERVER_MAX_EVENTS 64
+#define SERVER_READ_SIZE (64 * 1024)
+#define SERVER_OUTPUT_HIGH_WATER (4u * 1024u * 1024u) // stop reading a connection with this much unsent
+
+typedef struct ByteBuffer
+{
+    char* data;
+    size_t length;
+    size_t capacity;
+} ByteBuffer;
+
+typedef struct Connection
+{
+    int fd;
+    ByteBuffer input;
+    ByteBuffer output;
+    size_t sent; // bytes of output already written to the socket
+    uint32_t events; // current epoll interest
+    bool peer_closed; // no more requests will arrive, close once the replies are out
+    struct Connection* prev;
+    struct Connection* next;
+} Connection;
+
+typedef struct Server
+{
+    int epoll_fd;
+    int listen_fd;
+    const MorseEncodeTable* encode_table; // shared by every connection, never written
+    const MorseDecodeTable* decode_table;
+    Connection* connections;
+} Server;
+
+static volatile sig_atomic_t server_stopping = 0;
+
+static void server_stop(int signal_number)
+{
+    (void)signal_number;
+    server_stopping = 1;
+}
+
+static bool buffer_reserve(ByteBuffer* buffer, size_t extra)
+{
+    if (buffer->capacity - buffer->length >= extra) return true;
+    size_t capacity = buffer->capacity > 0 ? buffer->capacity * 2 : 4096;
+    if (capacity < buffer->length + extra) capacity = buffer->length + extra;
+    char* data = realloc(buffer->data, capacity);
+    if (!data) { return false; }
+    buffer->data = data;
+    buffer->capacity = capacity;
+    return true;
+}
+
+static void put_u32(char* bytes, uint32_t value)
+{
+    bytes[0] = (char)(value >> 24);
+    bytes[1] = (char)(value >> 16);
+    bytes[2] = (char)(value >> 8);
+    bytes[3] = (char)value;
+}
+
+static uint32_t get_u32(const char* bytes)
+{
+    const unsigned char* u = (const unsigned char*)bytes;
+    return (uint32_t)u[0] << 24 | (uint32_t)u[1] << 16 | (uint32_t)u[2] << 8 | (uint32_t)u[3];
+}
+
+static void put_header(char* frame, uint8_t status, size_t length)
+{
+    frame[0] = (char)status;
+    put_u32(frame + 1, (uint32_t)length);
+}
+
+static bool respond_message(Connection* connection, uint8_t status, const char* message)
+{
+    size_t length = strlen(message);
+    if (!buffer_reserve(&connection->output, MORSE_FRAME_HEADER_SIZE + length)) { return false; }
+    char* frame = connection->output.data + connection->output.length;
+    put_header(frame, status, length);
+    MEMORY_COPY(frame + MORSE_FRAME_HEADER_SIZE, message, length);
+    connection->output.length += MORSE_FRAME_HEADER_SIZE + length;
+    return true;
+}
+
+// Translate one request straight into the connection's output buffer
+static bool handle_request(const Server* server, Connection* connection, char operation,
+                           const char* payload, size_t length)
+{
+    ByteBuffer* output = &connection->output;
+    if (operation == MORSE_REQUEST_ENCODE)
+    {
+        size_t size = morse_encode_size_with_table(server->encode_table, payload, length);
+        if (size > MORSE_SERVER_MAX_PAYLOAD) { return respond_message(connection, MORSE_STATUS_ERROR, "Response too large"); }
+        if (!buffer_reserve(output, MORSE_FRAME_HEADER_SIZE + size + 1)) { return false; }
+
+        char* frame = output->data + output->length;
+        morse_encode_into_with_table(server->encode_table, payload, length, frame + MORSE_FRAME_HEADER_SIZE, size + 1);
+        put_header(frame, MORSE_STATUS_OK, size);
+        output->length += MORSE_FRAME_HEADER_SIZE + size;
+        return true;
+    }
+    if (operation == MORSE_REQUEST_DECODE)
+    {
+        // Every output byte consumes at least one input byte
+        if (!buffer_reserve(output, MORSE_FRAME_HEADER_SIZE + length + 1)) { return false; }
+
+        char* frame = output->data + output->length;
+        MorseDecoder decoder;
+        morse_decoder_init_with_table(&decoder, server->decode_table, MORSE_DECODE_STRICT);
+        size_t written = 0;
+        if (!morse_decoder_feed(&decoder, payload, length, frame + MORSE_FRAME_HEADER_SIZE, &written))
+        {
+            char message[96];
+            snprintf(message, sizeof(message), "Invalid character at offset %zu", decoder.error_offset);
+            return respond_message(connection, MORSE_STATUS_INVALID, message);
+        }
+        written += morse_decoder_finish(&decoder, frame + MORSE_FRAME_HEADER_SIZE + written);
+        put_header(frame, MORSE_STATUS_OK, written);
+        output->length += MORSE_FRAME_HEADER_SIZE + written;
+        return true;
+    }
+    return respond_message(connection, MORSE_STATUS_ERROR, "Unknown operation");
+}
+
+static bool output_backlogged(const Connection* connection)
+{
+    return connection->output.length - connection->sent >= SERVER_OUTPUT_HIGH_WATER;
+}
+
+// Answer every complete request in the input buffer, in order
+static bool connection_process(const Server* server, Connection* connection)
+{
+    ByteBuffer* input = &connection->input;
+    size_t pos = 0;
+    while (!output_backlogged(connection) && input->length - pos >= MORSE_FRAME_HEADER_SIZE)
+    {
+        uint32_t length = get_u32(input->data + pos + 1);
+        if (length > MORSE_SERVER_MAX_PAYLOAD) { return false; }
+        if (input->length - pos - MORSE_FRAME_HEADER_SIZE < length) break;
+
+        const char* payload = input->data + pos + MORSE_FRAME_HEADER_SIZE;
+        if (!handle_request(server, connection, input->data[pos], payload, length)) { return false; }
+        pos += MORSE_FRAME_HEADER_SIZE + length;
+    }
+    // Keep the partial frame, if any, at the front
+    memmove(input->data, input->data + pos, input->length - pos);
+    input->length -= pos;
+    return true;
+}
+
+static bool connection_watch(const Server* server, Connection* connection)
+{
+    uint32_t events = 0;
+    if (!connection->peer_closed && !output_backlogged(connection)) events |= EPOLLIN;
+    if (connection->sent < connection->output.length) events |= EPOLLOUT;
+    if (events == connection->events) return true;
+
+    struct epoll_event event = { .events = events, .data.ptr = connection };
+    connection->events = events;
+    return epoll_ctl(server->epoll_fd, EPOLL_CTL_MOD, connection->fd, &event) == 0;
+}
+
+static bool connection_flush(Connection* connection)
+{
+    ByteBuffer* output = &connection->output;
+    while (connection->sent < output->length)
+    {
+        ssize_t sent = send(connection->fd, output->data + connection->sent, output->length - connection->sent, MSG_NOSIGNAL);
+        if (sent < 0)
+        {
+            if (errno == EINTR) continue;
+            if (errno == EAGAIN || errno == EWOULDBLOCK) break;
+            return false;
+        }
+        connection->sent += (size_t)sent;
+    }
+    if (connection->sent == output->length)
+    {
+        output->length = 0;
+        connection->sent = 0;
+    }
+    return true;
+}
+
+static bool connection_read(const Server* server, Connection* connection)
+{
+    while (!connection->peer_closed && !output_backlogged(connection))
+    {
+        if (!buffer_reserve(&connection->input, SERVER_READ_SIZE)) { return false; }
+        ByteBuffer* input = &connection->input;
+        ssize_t got = read(connection->fd, input->data + input->length, input->capacity - input->length);
+        if (got < 0)
+        {
+            if (errno == EINTR) continue;
+            if (errno == EAGAIN || errno == EWOULDBLOCK) break;
+            return false;
+        }
+        if (got == 0)
+        {
+            connection->peer_closed = true;
+            break;
+        }
+        input->length += (size_t)got;
+        if (!connection_process(server, connection)) { return false; }
+    }
+    return true;
+}
+
+// Read, answer and write until the socket would block; false closes the connection
+static bool connection_service(const Server* server, Connection* connection, uint32_t events)
+{
+    if (events & EPOLLOUT)
+    {
+        if (!connection_flush(connection)) { return false; }
+        // Requests held back while the output was backlogged
+        if (!connection_process(server, connection)) { return false; }
+    }
+    if (events & (EPOLLIN | EPOLLHUP | EPOLLERR))
+    {
+        if (!connection_read(server, connection)) { return false; }
+    }
+    if (!connection_flush(connection)) { return false; }
+
+    bool drained = connection->sent == connection->output.length;
+    if (connection->peer_closed && drained) { return false; }
+    return connection_watch(server, connection);
+}
+
+static void connection_close(Server* server, Connection* connection)
+{
+    epoll_ctl(server->epoll_fd, EPOLL_CTL_DEL, connection->fd, NULL);
+    close(connection->fd);
+    if (connection->prev) connection->prev->next = connection->next;
+    else server->connections = connection->next;
+    if (connection->next) connection->next->prev = connection->prev;
+    free(connection->input.data);
+    free(connection->output.data);
+    free(connection);
+}
+
+static void server_accept(Server* server)
+{
+    for (;;)
+    {
+        int fd = accept4(server->listen_fd, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0)
+        {
+            if (errno == EINTR) continue;
+            if (errno != EAGAIN && errno != EWOULDBLOCK) perror("accept");
+            return;
+        }
+
+        Connection* connection = calloc(1, sizeof(Connection));
+        if (!connection)
+        {
+            fprintf(stderr, "Memory allocation failed\n");
+            close(fd);
+            continue;
+        }
+        connection->fd = fd;
+        connection->events = EPOLLIN;
+        struct epoll_event event = { .events = EPOLLIN, .data.ptr = connection };
+        if (epoll_ctl(server->epoll_fd, EPOLL_CTL_ADD, fd, &event) != 0)
+        {
+            perror("epoll_ctl");
+            close(fd);
+            free(connection);
+            continue;
+        }
+        connection->next = server->connections;
+        if (server->connections) server->connections->prev = connection;
+        server->connections = connection;
+    }
+}
+
+static int server_listen(const char* socket_path)
+{
+    struct sockaddr_un address = { .sun_family = AF_UNIX };
+    if (strlen(socket_path) >= sizeof(address.sun_path))
+    {
+        fprintf(stderr, "Socket path too long: %s\n", socket_path);
+        return -1;
+    }
+    strcpy(address.sun_path, socket_path);
+
+    // A socket left behind by an earlier server is replaced, anything else is kept
+    struct stat info;
+    if (lstat(socket_path, &info) == 0)
+    {
+        if (!S_ISSOCK(info.st_mode))
+        {
+            fprintf(stderr, "Not a socket: %s\n", socket_path);
+            return -1;
+        }
+        unlink(socket_path);
+    }
+
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd < 0)
+    {
+        perror("socket");
+        return -1;
+    }
+    if (bind(fd, (struct sockaddr*)&address, sizeof(address)) != 0 || listen(fd, SOMAXCONN) != 0)
+    {
+        perror(socket_path);
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+int morse_server_run(const char* socket_path, const MorseEncodeTable* encode_table,
+                     const MorseDecodeTable* decode_table)
+{
+    if (!socket_path || !encode_table || !decode_table) { return 1; }
+
+    Server server = { -1, -1, encode_table, decode_table, NULL };
+    server.listen_fd = server_listen(socket_path);
+    if (server.listen_fd < 0) { return 1; }
+
+    server.epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    struct epoll_event listen_event = { .events = EPOLLIN, .data.ptr = NULL };
+    if (server.epoll_fd < 0 || epoll_ctl(server.epoll_fd, EPOLL_CTL_ADD, server.listen_fd, &listen_event) != 0)
+    {
+        perror("epoll");
+        if (server.epoll_fd >= 0) close(server.epoll_fd);
+        close(server.listen_fd);
+        unlink(socket_path);
+        return 1;
+    }
+
+    // No SA_RESTART, so a signal wakes epoll_wait
+    struct sigaction action = { .sa_handler = server_stop };
+    sigemptyset(&action.sa_mask);
+    sigaction(SIGINT, &action, NULL);
+    sigaction(SIGTERM, &action, NULL);
+    server_stopping = 0;
+
+    int status = 0;
+    struct epoll_event events[SERVER_MAX_EVENTS];
+    while (!server_stopping)
+    {
+        int ready = epoll_wait(server.epoll_fd, events, SERVER_MAX_EVENTS, -1);
+        if (ready < 0)
+        {
+            if (errno == EINTR) continue;
+            perror("epoll_wait");
+            status = 1;
+            break;
+        }
+        for (int i = 0; i < ready; i++)
+        {
+            Connection* connection = events[i].data.ptr;
+            if (!connection)
+            {
+                server_accept(&server);
+            } else if (!connection_service(&server, connection, events[i].events))
+            {
+                connection_close(&server, connection);
+            }
+        }
+    }
+
+    while (server.connections) connection_close(&server, server.connections);
+    close(server.epoll_fd);
+    close(server.listen_fd);
+    unlink(socket_path);
+    return status;
+}
@@ -0,0 +1,58 @@
+#include "morse-stats.h"
+#include <inttypes.h>
+#include <string.h>
+
+
+#ifdef MORSE_STATS
+
+MorseStatsCounters morse_stats_counters;
+
+bool morse_stats_enabled(void)
+{
+    return true;
+}
+
+void morse_stats_snapshot(MorseStats* stats)
+{
+#define MORSE_STATS_LOAD(name) stats->name = atomic_load_explicit(&morse_stats_counters.name, memory_order_relaxed);
+    MORSE_STATS_COUNTERS(MORSE_STATS_LOAD)
+#undef MORSE_STATS_LOAD
+}
+
+void morse_stats_reset(void)
+{
+#define MORSE_STATS_CLEAR(name) atomic_store_explicit(&morse_stats_counters.name, 0, memory_order_relaxed);
+    MORSE_STATS_COUNTERS(MORSE_STATS_CLEAR)
+#undef MORSE_STATS_CLEAR
+}
+
+#else
+
+bool morse_stats_enabled(void)
+{
+    return false;
+}
+
+void morse_stats_snapshot(MorseStats* stats)
+{
+    memset(stats, 0, sizeof(*stats));
+}
+
+void morse_stats_reset(void)
+{
+}
+
+#endif // MORSE_STATS
+
+bool morse_stats_write_json(FILE* file)
+{
+    MorseStats stats;
+    morse_stats_snapshot(&stats);
+
+    fprintf(file, "{\"enabled\": %s", morse_stats_enabled() ? "true" : "false");
+#define MORSE_STATS_PRINT(name) fprintf(file, ", \"" #name "\": %" PRIu64, stats.name);
+    MORSE_STATS_COUNTERS(MORSE_STATS_PRINT)
+#undef MORSE_STATS_PRINT
+    fprintf(file, "}\n");
+    return fflush(file) == 0 && !ferror(file);
+}
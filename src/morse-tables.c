@@ -0,0 +1,8 @@
+#include "morse-tables.h"
+#include "morse-tables-data.h" // generated into build/gen by the makefile
+
+
+const BTreeNode* morse_tree_default(void)
+{
+    return MORSE_TREE_DEFAULT;
+}
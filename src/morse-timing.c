@@ -0,0 +1,217 @@
+#include "morse-timing.h"
+#include "memory-copy.h"
+
+
+#define TIMING_ADAPT 0.25 // fraction of the way a centre moves towards each duration
+#define TIMING_SINGLES 4   // one-element letters in a row that suggest the sender slowed down
+
+// Same pace as `unit` in PARIS proportions
+static void timing_rescale(MorseTimingDecoder* decoder, double unit)
+{
+    decoder->dot = unit;
+    decoder->dash = 3 * unit;
+    decoder->element = unit;
+    decoder->letter = 0;
+    decoder->word = 0;
+}
+
+// Keep the mark centres in proportion to the element gap, which every speed and spacing shares
+static void timing_clamp(MorseTimingDecoder* decoder)
+{
+    double unit = decoder->element;
+    if (decoder->dot > 1.5 * unit) decoder->dot = 1.5 * unit;
+    if (decoder->dash > 4 * unit) decoder->dash = 4 * unit;
+    if (decoder->dash < 2 * decoder->dot) decoder->dash = 2 * decoder->dot;
+}
+
+// Letter gaps are at least three units in any spacing, so a longer letter centre (which may
+// still be a word gap) does not move the threshold
+static double letter_threshold(const MorseTimingDecoder* decoder)
+{
+    double letter = 3 * decoder->element;
+    if (decoder->letter > 0 && decoder->letter < letter) letter = decoder->letter;
+    return (decoder->element + letter) / 2;
+}
+
+// Marks are classified when their letter ends, against the centres of that moment
+static char timing_letter(const MorseTimingDecoder* decoder)
+{
+    if (decoder->symbols > MORSE_CODE_MAX_LENGTH) return '?';
+    double threshold = (decoder->dot + decoder->dash) / 2;
+    unsigned bits = 0;
+    for (size_t i = 0; i < decoder->symbols; i++)
+    {
+        if (decoder->marks[i] > threshold) bits |= 1u << i;
+    }
+    char decoded = decoder->table->alnum_character[MORSE_CODE_PACK(bits, decoder->symbols)];
+    return decoded != '\0' ? decoded : '?';
+}
+
+// The key has been up for `length`: end the letter, then the word, once the gap is long enough.
+// The word gap is only judged once a letter gap has been seen.
+static size_t timing_gap(MorseTimingDecoder* decoder, double length, char* output)
+{
+    size_t len = 0;
+    if (decoder->symbols > 0 && length >= letter_threshold(decoder))
+    {
+        // Track runs of one-element letters and the shortest mark or gap in them
+        if (decoder->symbols == 1)
+        {
+            double shortest = decoder->marks[0] < length ? decoder->marks[0] : length;
+            if (decoder->singles == 0 || shortest < decoder->singles_shortest) decoder->singles_shortest = shortest;
+            decoder->singles++;
+        } else
+        {
+            decoder->singles = 0;
+        }
+        output[len++] = timing_letter(decoder);
+        decoder->symbols = 0;
+        decoder->word_open = true;
+    }
+    if (decoder->word_open && decoder->letter > 0 && length >= (decoder->letter + decoder->word) / 2)
+    {
+        output[len++] = ' ';
+        decoder->word_open = false;
+    }
+    return len;
+}
+
+static void timing_append(MorseTimingDecoder* decoder, double gap, double length)
+{
+    if (decoder->symbols <= MORSE_CODE_MAX_LENGTH)
+    {
+        decoder->marks[decoder->symbols] = length;
+        decoder->gaps[decoder->symbols] = gap;
+    }
+    decoder->symbols++;
+}
+
+// A mark or gap far shorter than the unit means the estimate came from dashes or letter
+// gaps: start over from `unit` and split the letter so far again where its gaps allow
+static size_t timing_restart(MorseTimingDecoder* decoder, double unit, char* output)
+{
+    timing_rescale(decoder, unit);
+    decoder->singles = 0;
+
+    size_t held = decoder->symbols <= MORSE_CODE_MAX_LENGTH ? decoder->symbols : 0;
+    double marks[MORSE_CODE_MAX_LENGTH + 1];
+    double gaps[MORSE_CODE_MAX_LENGTH + 1];
+    MEMORY_COPY(marks, decoder->marks, held * sizeof(double));
+    MEMORY_COPY(gaps, decoder->gaps, held * sizeof(double));
+    if (held > 0) decoder->symbols = 0;
+
+    size_t len = 0;
+    for (size_t i = 0; i < held; i++)
+    {
+        if (i > 0) len += timing_gap(decoder, gaps[i], output + len);
+        timing_append(decoder, gaps[i], marks[i]);
+    }
+    return len;
+}
+
+// A slower sender shows as marks far longer than a dash, or, when it sends few dashes, as
+// element gaps taken for letter gaps: a run of one-element letters whose shortest mark or gap
+// is well over the unit. Either way the unit is taken from the new evidence.
+static double timing_slower_unit(const MorseTimingDecoder* decoder, double length)
+{
+    if (length > 1.5 * decoder->dash) return length / 3;
+    if (decoder->singles >= TIMING_SINGLES && decoder->singles_shortest > 1.5 * decoder->element)
+    {
+        return decoder->singles_shortest;
+    }
+    return 0;
+}
+
+static size_t timing_mark_end(MorseTimingDecoder* decoder, double length, char* output)
+{
+    size_t len = 0;
+    double slower = decoder->dot == 0 ? 0 : timing_slower_unit(decoder, length);
+    if (decoder->dot == 0) timing_rescale(decoder, length);
+    else if (length < decoder->dot / 2 || slower > 0)
+    {
+        len = timing_restart(decoder, slower > 0 ? slower : length, output);
+        if (decoder->symbols > 0) len += timing_gap(decoder, decoder->mark_gap, output + len);
+    }
+
+    if (length > (decoder->dot + decoder->dash) / 2) decoder->dash += (length - decoder->dash) * TIMING_ADAPT;
+    else decoder->dot += (length - decoder->dot) * TIMING_ADAPT;
+    timing_clamp(decoder);
+    timing_append(decoder, decoder->mark_gap, length);
+    return len;
+}
+
+// A long gap well under the letter centre shows the first one was a word gap
+static size_t timing_gap_end(MorseTimingDecoder* decoder, double length, char* output)
+{
+    if (decoder->dot == 0) return 0; // silence before the first mark
+    if (length < decoder->element / 2) return timing_restart(decoder, length, output);
+
+    if (length < letter_threshold(decoder)) decoder->element += (length - decoder->element) * TIMING_ADAPT;
+    else if (decoder->letter == 0 || length < decoder->letter * 3 / 5)
+    {
+        decoder->letter = length;
+        decoder->word = length * 7 / 3;
+    }
+    else if (length < (decoder->letter + decoder->word) / 2) decoder->letter += (length - decoder->letter) * TIMING_ADAPT;
+    else decoder->word += (length - decoder->word) * TIMING_ADAPT;
+
+    if (decoder->letter > 0 && decoder->letter < 2 * decoder->element) decoder->letter = 2 * decoder->element;
+    if (decoder->word < 1.5 * decoder->letter) decoder->word = 1.5 * decoder->letter;
+    timing_clamp(decoder);
+    return 0;
+}
+
+void morse_timing_init(MorseTimingDecoder* decoder, const MorseDecodeTable* table)
+{
+    *decoder = (MorseTimingDecoder){ .table = table };
+}
+
+size_t morse_timing_feed(MorseTimingDecoder* decoder, bool key_down, double duration, char* output)
+{
+    if (!(duration > 0)) { return 0; }
+
+    size_t len = 0;
+    if (key_down)
+    {
+        if (decoder->mark == 0)
+        {
+            if (decoder->gap > 0) len = timing_gap_end(decoder, decoder->gap, output);
+            decoder->mark_gap = decoder->gap;
+            decoder->gap = 0;
+        }
+        decoder->mark += duration;
+        return len;
+    }
+
+    if (decoder->mark > 0)
+    {
+        len = timing_mark_end(decoder, decoder->mark, output);
+        decoder->mark = 0;
+    }
+    decoder->gap += duration;
+    if (decoder->dot > 0) len += timing_gap(decoder, decoder->gap, output + len);
+    return len;
+}
+
+size_t morse_timing_finish(MorseTimingDecoder* decoder, char* output)
+{
+    size_t len = 0;
+    if (decoder->mark > 0) len = timing_mark_end(decoder, decoder->mark, output);
+    if (decoder->symbols > 0) output[len++] = timing_letter(decoder);
+
+    decoder->mark = 0;
+    decoder->gap = 0;
+    decoder->mark_gap = 0;
+    decoder->symbols = 0;
+    decoder->word_open = false;
+    decoder->singles = 0;
+    return len;
+}
+
+double morse_timing_wpm(const MorseTimingDecoder* decoder, double unit_seconds)
+{
+    if (decoder->dot == 0 || !(unit_seconds > 0)) { return 0; }
+    // PARIS: a dot lasts 1.2 / wpm seconds; dashes count as three
+    double dot = (decoder->dot + decoder->dash / 3) / 2;
+    return 1.2 / (dot * unit_seconds);
+}
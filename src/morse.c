@@ -1,74 +1,215 @@
 #include <ctype.h>
+#include "arena.h"
 #include "morse.h"
+#include "morse-scan.h"
+#include "morse-stats.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
 
+// Record one tree node in the encode and/or decode index
+static void code_table_record(char alnum_character, uint8_t bits, uint8_t length, MorseEncodeTable* encode, MorseDecodeTable* decode)
+{
+    MorseCode code = MORSE_CODE_PACK(bits, length);
+    if (decode) decode->alnum_character[code] = alnum_character;
+
+    unsigned char ch = (unsigned char)alnum_character;
+    bool encodable = ch != '\0' && isalnum(ch) && !islower(ch);
+    // Shortest code wins, matching a breadth-first search of the tree
+    if (encode && encodable && (encode->code[ch] == MORSE_CODE_NONE || length < encode->length[ch]))
+    {
+        encode->code[ch] = code;
+        encode->length[ch] = length;
+    }
+}
+
+#ifdef MORSE_TREE_FLAT
+
+// Flat backend: the whole tree is one implicit binary heap of characters
+
 BTreeNode* morse_tree_init(void)
 {
-    BTreeNode* root = malloc(sizeof(BTreeNode));
+    BTreeNode* root = calloc(1, sizeof(BTreeNode));
+    MORSE_STATS_MALLOC(root, sizeof(BTreeNode));
     if (!root) { return NULL; }
-    root->alnum_character = '\0';
-    root->left = NULL;
-    root->right = NULL;
     return root;
 }
 
 void morse_tree_delete(BTreeNode* root)
 {
-    if (!root) return;
-    morse_tree_delete(root->left);
-    morse_tree_delete(root->right);
+    MORSE_STATS_FREE(root);
     free(root);
 }
 
 // Insert an alphabetic character into the morse code tree
 void morse_tree_insert(BTreeNode* root, const char* morse_code, char alnum_character)
 {
-    BTreeNode* current = root;
-    for (size_t i = 0; i < strlen(morse_code); i++)
+    size_t index = 0;
+    for (const char* ptr = morse_code; *ptr; ptr++)
     {
-        char ch = morse_code[i];
-        if (ch == '.')
+        if (*ptr != '.' && *ptr != '-') continue;
+        index = MORSE_TREE_FLAT_CHILD(index, *ptr == '-');
+        if (index >= MORSE_TREE_FLAT_SIZE)
         {
-            if (!current->left)
-            {
-                current->left = malloc(sizeof(BTreeNode));
-                current->left->alnum_character = '\0';
-                current->left->left = NULL;
-                current->left->right = NULL;
-            }
-            current = current->left;
-        } else if (ch == '-')
+            fprintf(stderr, "Morse code too long: %s\n", morse_code);
+            return;
+        }
+    }
+    root->alnum_character[index] = alnum_character;
+}
+
+static void flat_tree_print(const BTreeNode* root, size_t index, char* morse_code, size_t length)
+{
+    if (index >= MORSE_TREE_FLAT_SIZE) return;
+    if (root->alnum_character[index] != '\0')
+    {
+        morse_code[length] = '\0';
+        printf("Character: %c, Morse Code: %s\n", root->alnum_character[index], morse_code);
+    }
+    morse_code[length] = '.';
+    flat_tree_print(root, MORSE_TREE_FLAT_CHILD(index, 0), morse_code, length + 1);
+    morse_code[length] = '-';
+    flat_tree_print(root, MORSE_TREE_FLAT_CHILD(index, 1), morse_code, length + 1);
+}
+
+//Print morse code dictionary
+void morse_tree_print(const BTreeNode* root)
+{
+    if (!root) return;
+    char morse_code[MORSE_CODE_MAX_LENGTH + 2];
+    flat_tree_print(root, 0, morse_code, 0);
+}
+
+// Decode `length` symbols straight from a buffer, no terminator needed
+char decode_letter_n(const BTreeNode* root, const char* morse_code, size_t length)
+{
+    if (!root || !morse_code) { return '\0'; }
+    size_t index = 0;
+    MORSE_STATS_ADD(tree_nodes_visited, 1);
+    for (size_t i = 0; i < length; i++)
+    {
+        char ch = morse_code[i];
+        if (ch != '.' && ch != '-') continue;
+        index = MORSE_TREE_FLAT_CHILD(index, ch == '-');
+        MORSE_STATS_ADD(tree_nodes_visited, 1);
+        if (index >= MORSE_TREE_FLAT_SIZE) { return '\0'; }
+    }
+    return root->alnum_character[index];
+}
+
+static void code_table_fill(const BTreeNode* root, size_t index, uint8_t bits, uint8_t length, MorseEncodeTable* encode, MorseDecodeTable* decode)
+{
+    if (index >= MORSE_TREE_FLAT_SIZE) return;
+    MORSE_STATS_ADD(tree_nodes_visited, 1);
+    code_table_record(root->alnum_character[index], bits, length, encode, decode);
+    code_table_fill(root, MORSE_TREE_FLAT_CHILD(index, 0), bits, length + 1, encode, decode);
+    code_table_fill(root, MORSE_TREE_FLAT_CHILD(index, 1), bits | (uint8_t)(1u << length), length + 1, encode, decode);
+}
+
+#define CODE_TABLE_FILL(root, encode, decode) code_table_fill(root, 0, 0, 0, encode, decode)
+
+// Depth-first search for the shortest code of `ch`, skipping subtrees no shorter than the best so far
+static void code_find(const BTreeNode* root, size_t index, unsigned char ch, uint8_t bits, uint8_t length, MorseCode* found, uint8_t* found_length)
+{
+    if (index >= MORSE_TREE_FLAT_SIZE || length >= *found_length) return;
+    MORSE_STATS_ADD(tree_nodes_visited, 1);
+    if ((unsigned char)root->alnum_character[index] == ch)
+    {
+        *found = MORSE_CODE_PACK(bits, length);
+        *found_length = length;
+        return;
+    }
+    code_find(root, MORSE_TREE_FLAT_CHILD(index, 0), ch, bits, length + 1, found, found_length);
+    code_find(root, MORSE_TREE_FLAT_CHILD(index, 1), ch, bits | (uint8_t)(1u << length), length + 1, found, found_length);
+}
+
+#define CODE_FIND(root, ch, found, found_length) code_find(root, 0, ch, 0, 0, found, found_length)
+
+#else
+
+// Pointer backend: every node lives in one arena, stored in front of the root
+typedef struct MorseTreeStorage
+{
+    Arena arena;
+    BTreeNode root;
+} MorseTreeStorage;
+
+#define MORSE_TREE_STORAGE(root) ((MorseTreeStorage*)(void*)((char*)(root) - offsetof(MorseTreeStorage, root)))
+
+// Room for the international alphabet, digits and punctuation in a single block
+#define MORSE_TREE_ARENA_BLOCK (sizeof(MorseTreeStorage) + 96 * sizeof(BTreeNode))
+
+static BTreeNode* tree_node_new(Arena* arena)
+{
+    BTreeNode* node = arena_alloc(arena, sizeof(BTreeNode));
+    if (!node) { return NULL; }
+    node->alnum_character = '\0';
+    node->left = NULL;
+    node->right = NULL;
+    return node;
+}
+
+BTreeNode* morse_tree_init(void)
+{
+    Arena arena;
+    arena_init(&arena, MORSE_TREE_ARENA_BLOCK);
+    MorseTreeStorage* storage = arena_alloc(&arena, sizeof(MorseTreeStorage));
+    if (!storage) { return NULL; }
+
+    // The arena now lives inside its own first block
+    storage->arena = arena;
+    storage->root = (BTreeNode){ '\0', NULL, NULL };
+    return &storage->root;
+}
+
+// Release the whole tree at once, `root` must come from morse_tree_init
+void morse_tree_delete(BTreeNode* root)
+{
+    if (!root) return;
+    Arena arena = MORSE_TREE_STORAGE(root)->arena;
+    arena_delete(&arena);
+}
+
+// Insert an alphabetic character into the morse code tree
+void morse_tree_insert(BTreeNode* root, const char* morse_code, char alnum_character)
+{
+    Arena* arena = &MORSE_TREE_STORAGE(root)->arena;
+    BTreeNode* current = root;
+    for (const char* ptr = morse_code; *ptr; ptr++)
+    {
+        if (*ptr != '.' && *ptr != '-') continue;
+        BTreeNode** child = *ptr == '.' ? &current->left : &current->right;
+        if (!*child) *child = tree_node_new(arena);
+        if (!*child)
         {
-            if (!current->right)
-            {
-                current->right = malloc(sizeof(BTreeNode));
-                current->right->alnum_character = '\0';
-                current->right->left = NULL;
-                current->right->right = NULL;
-            }
-            current = current->right;
+            fprintf(stderr, "Memory allocation failed\n");
+            return;
         }
+        current = *child;
     }
     current->alnum_character = alnum_character;
 }
 
 //Print morse code dictionary
-void morse_tree_print(BTreeNode* root)
+void morse_tree_print(const BTreeNode* root)
 {
     if (!root) return;
 
+    // Prefix strings and the stack's heap buffer all come from one scratch arena,
+    // so every exit path releases them with a single arena_delete
+    Arena scratch;
+    arena_init(&scratch, ARENA_DEFAULT_BLOCK_SIZE);
+    Allocator scratch_allocator = arena_allocator(&scratch);
+
     stack(Node) node_stack;
-    stack_init(Node, &node_stack);
+    stack_init_with_allocator(Node, &node_stack, &scratch_allocator);
 
-    char* empty = malloc(sizeof(char));
+    char* empty = arena_alloc(&scratch, sizeof(char));
     if (!empty)
     {
         fprintf(stderr, "Memory allocation failed\n");
-        stack_delete(Node, &node_stack);
-        return;
+        goto cleanup;
     }
     empty[0] = '\0';
     Node initial = { .node = root, .morse_code = empty };
@@ -77,9 +218,7 @@ void morse_tree_print(BTreeNode* root)
     if (not_succesfully_added)
     {
         fprintf(stderr, "Stack push failed.\n");
-        free(empty);
-        stack_delete(Node, &node_stack);
-        return;
+        goto cleanup;
     }
 
     while (!stack_empty(Node, &node_stack))
@@ -87,7 +226,7 @@ void morse_tree_print(BTreeNode* root)
         Node current = stack_peek(Node, &node_stack);
         stack_pop(Node, &node_stack);
 
-        BTreeNode* node = current.node;
+        const BTreeNode* node = current.node;
         char* morse_code = current.morse_code;
 
         bool not_empty_character = node->alnum_character != '\0';
@@ -97,197 +236,223 @@ void morse_tree_print(BTreeNode* root)
         }
 
         // Push right child (dash) first so left is processed first
-        if (node->right)
+        BTreeNode* children[2] = { node->right, node->left };
+        const char symbols[2] = { '-', '.' };
+        for (size_t i = 0; i < 2; i++)
         {
-            size_t len = strlen(morse_code);
-            char* right_str = malloc(len + 2); // +1 for '-' and +1 for '\0'
-            if (!right_str)
-            {
-                fprintf(stderr, "Memory allocation failed\n");
-                return;
-            } else
-            {
-                MEMORY_COPY(right_str, morse_code, len);
-                right_str[len] = '-';
-                right_str[len + 1] = '\0';
+            if (!children[i]) continue;
 
-                Node reverse_node = { .node = node->right, .morse_code = right_str };
-                bool unsuccessful_push = !stack_push(Node, &node_stack, reverse_node);
-                if (unsuccessful_push)
-                {
-                    fprintf(stderr, "Stack push failed.\n");
-                    free(right_str);
-                }
-            }
-        }
-        if (node->left)
-        {
             size_t len = strlen(morse_code);
-            char* left_str = malloc(len + 2); // +1 for '.' and +1 for '\0'
-            if (!left_str)
+            char* child_str = arena_alloc(&scratch, len + 2); // +1 for the symbol and +1 for '\0'
+            if (!child_str)
             {
                 fprintf(stderr, "Memory allocation failed\n");
-                return;
-            } else
-            {
-                MEMORY_COPY(left_str, morse_code, len);
-                left_str[len] = '.';
-                left_str[len + 1] = '\0';
+                goto cleanup;
+            }
+            MEMORY_COPY(child_str, morse_code, len);
+            child_str[len] = symbols[i];
+            child_str[len + 1] = '\0';
 
-                Node dot_node = { .node = node->left, .morse_code = left_str };
-                bool unsuccessful_push = !stack_push(Node, &node_stack, dot_node);
-                if (unsuccessful_push)
-                {
-                    fprintf(stderr, "Stack push failed.\n");
-                    free(left_str);
-                }
+            Node child = { .node = children[i], .morse_code = child_str };
+            bool unsuccessful_push = !stack_push(Node, &node_stack, child);
+            if (unsuccessful_push)
+            {
+                fprintf(stderr, "Stack push failed.\n");
+                goto cleanup;
             }
         }
     }
-    stack_delete(Node, &node_stack);
-}
 
-bool is_valid_morse_message(const char* message)
-{
-    for (size_t i = 0; i < strlen(message); i++)
-    {
-        char ch = message[i];
-        if (ch != '.' && ch != '-' && ch != ' ' && ch != '/') { return false; }
-    }
-    return true;
+cleanup:
+    stack_delete(Node, &node_stack);
+    arena_delete(&scratch);
 }
 
-char decode_letter(BTreeNode* root, const char* morse_code)
+// Decode `length` symbols straight from a buffer, no terminator needed
+char decode_letter_n(const BTreeNode* root, const char* morse_code, size_t length)
 {
     if (!root || !morse_code) { return '\0'; }
-    BTreeNode* current = root;
-    for (size_t i = 0; i < strlen(morse_code); i++)
+    const BTreeNode* current = root;
+    MORSE_STATS_ADD(tree_nodes_visited, 1);
+    for (size_t i = 0; i < length; i++)
     {
         char ch = morse_code[i];
         if (ch == '.')
         {
             if (!current->left) { return '\0'; }
             current = current->left;
+            MORSE_STATS_ADD(tree_nodes_visited, 1);
         } else if (ch == '-')
         {
             if (!current->right) { return '\0'; }
             current = current->right;
+            MORSE_STATS_ADD(tree_nodes_visited, 1);
         }
     }
     return current->alnum_character;
 }
 
-char* encode_letter(BTreeNode* root, const char alnum_character)
+static void code_table_fill(const BTreeNode* node, uint8_t bits, uint8_t length, MorseEncodeTable* encode, MorseDecodeTable* decode)
 {
-    if (!root || !isalnum(alnum_character)) { return NULL; }
-    bool not_uppercase = !isupper(alnum_character);
-    char ch = not_uppercase ? toupper(alnum_character) : alnum_character;
+    if (!node || length > MORSE_CODE_MAX_LENGTH) return;
+    MORSE_STATS_ADD(tree_nodes_visited, 1);
+    code_table_record(node->alnum_character, bits, length, encode, decode);
+    code_table_fill(node->left, bits, length + 1, encode, decode);
+    code_table_fill(node->right, bits | (uint8_t)(1u << length), length + 1, encode, decode);
+}
 
-    queue(Node) node_queue;
-    queue_init(Node, &node_queue);
+#define CODE_TABLE_FILL(root, encode, decode) code_table_fill(root, 0, 0, encode, decode)
 
-    char* empty = malloc(sizeof(char));
-    if (!empty)
+static void code_find(const BTreeNode* node, unsigned char ch, uint8_t bits, uint8_t length, MorseCode* found, uint8_t* found_length)
+{
+    if (!node || length >= *found_length) return;
+    MORSE_STATS_ADD(tree_nodes_visited, 1);
+    if ((unsigned char)node->alnum_character == ch)
     {
-        fprintf(stderr, "Memory allocation failed\n");
-        queue_delete(Node, &node_queue);
-        return NULL;
+        *found = MORSE_CODE_PACK(bits, length);
+        *found_length = length;
+        return;
     }
-    empty[0] = '\0';
-    Node initial = { .node = root, .morse_code = empty };
+    code_find(node->left, ch, bits, length + 1, found, found_length);
+    code_find(node->right, ch, bits | (uint8_t)(1u << length), length + 1, found, found_length);
+}
+
+#define CODE_FIND(root, ch, found, found_length) code_find(root, ch, 0, 0, found, found_length)
+
+#endif // MORSE_TREE_FLAT
 
-    bool unsuccessful_enqueue = !queue_enque(Node, &node_queue, initial);
-    if (unsuccessful_enqueue)
+bool is_valid_morse_message(const char* message)
+{
+    for (const char* ptr = message; *ptr; ptr++)
     {
-        fprintf(stderr, "Queue enqueue failed.\n");
-        free(empty);
-        queue_delete(Node, &node_queue);
-        return NULL;
+        char ch = *ptr;
+        if (ch != '.' && ch != '-' && ch != ' ' && ch != '/') { return false; }
     }
+    return true;
+}
 
-    while (!queue_empty(Node, &node_queue))
-    {
-        Node current = queue_peek(Node, &node_queue);
-        queue_deque(Node, &node_queue);
+char decode_letter(const BTreeNode* root, const char* morse_code)
+{
+    if (!root || !morse_code) { return '\0'; }
+    size_t length = strlen(morse_code);
+    char decoded = decode_letter_n(root, morse_code, length);
+    MORSE_STATS_CALL(decode_calls, length, decoded != '\0');
+    return decoded;
+}
 
-        BTreeNode* node = current.node;
-        char* morse_code = current.morse_code;
+// Build the character -> code index with a single traversal of the tree
+void morse_encode_table_build(const BTreeNode* root, MorseEncodeTable* table)
+{
+    if (!table) return;
+    memset(table, 0, sizeof(*table));
+    if (root) CODE_TABLE_FILL(root, table, NULL);
 
-        if (node->alnum_character == ch)
-        {
-            size_t len = strlen(morse_code);
-            char* result = malloc(len + 1);
-            if (!result)
-            {
-                free(morse_code);
-                queue_delete(Node, &node_queue);
-                return NULL;
-            }
-            MEMORY_COPY(result, morse_code, len);
-            result[len] = '\0';
-            free(morse_code);
-            queue_delete(Node, &node_queue);
-            return result;
-        }
-        if (node->left)
-        {
-            size_t len = strlen(morse_code);
-            char* left_str = malloc(len + 2); // +1 for '.' +1 for '\0'
-            if (left_str)
-            {
-                MEMORY_COPY(left_str, morse_code, len);
-                left_str[len] = '.';
-                left_str[len + 1] = '\0';
-                Node left_node = { .node = node->left, .morse_code = left_str };
-                bool unsuccessful_enqueue = !queue_enque(Node, &node_queue, left_node);
-                if (unsuccessful_enqueue)
-                {
-                    fprintf(stderr, "Queue enqueue failed.\n");
-                    free(left_str);
-                }
-            }
-        }
-        if (node->right)
-        {
-            size_t len = strlen(morse_code);
-            char* right_str = malloc(len + 2); // +1 for '-' +1 for '\0'
-            if (right_str)
-            {
-                MEMORY_COPY(right_str, morse_code, len);
-                right_str[len] = '-';
-                right_str[len + 1] = '\0';
-                Node right_node = { .node = node->right, .morse_code = right_str };
-                bool unsuccessful_enqueue = !queue_enque(Node, &node_queue, right_node);
-                if (unsuccessful_enqueue)
-                {
-                    fprintf(stderr, "Queue enqueue failed.\n");
-                    free(right_str);
-                }
-            }
-        }
-        free(morse_code);
+    // Lowercase letters share the code of their uppercase counterpart
+    for (int ch = 0; ch < 256; ch++)
+    {
+        if (!islower(ch)) continue;
+        table->code[ch] = table->code[toupper(ch)];
+        table->length[ch] = table->length[toupper(ch)];
     }
-    queue_delete(Node, &node_queue);
-    return NULL;
+
+    // Output size per character, matches encode_char
+    for (int ch = 0; ch < 256; ch++)
+    {
+        if (ch == ' ') table->width[ch] = 2;
+        else if (!isalnum(ch)) table->width[ch] = 0;
+        else if (table->code[ch] == MORSE_CODE_NONE) table->width[ch] = 1;
+        else table->width[ch] = table->length[ch] + 1;
+    }
+}
+
+// Build the packed code -> character index with a single traversal of the tree
+void morse_decode_table_build(const BTreeNode* root, MorseDecodeTable* table)
+{
+    if (!table) return;
+    memset(table, 0, sizeof(*table));
+    if (root) CODE_TABLE_FILL(root, NULL, table);
+}
+
+static size_t write_code(char* output, MorseCode code)
+{
+    size_t len = 0;
+    for (; code > 1; code >>= 1) { output[len++] = (code & 1u) ? '-' : '.'; }
+    return len;
+}
+
+// Copy as much of `length` bytes as fits below the terminator, snprintf style
+static void copy_truncated(char* output, size_t capacity, size_t offset, const char* source, size_t length)
+{
+    if (offset + 1 >= capacity) return;
+    size_t room = capacity - 1 - offset;
+    MEMORY_COPY(output + offset, source, length < room ? length : room);
+}
+
+// Write the code of one character into `output`, returns the code length (0 if the
+// character has no code); at most capacity - 1 bytes and a terminator are written
+size_t encode_letter_into(const BTreeNode* root, const char alnum_character, char* output, size_t capacity)
+{
+    if (capacity > 0) output[0] = '\0';
+    if (!root || !isalnum((unsigned char)alnum_character)) { return 0; }
+
+    // Stop at the shortest match rather than index the whole tree; lowercase letters
+    // share the code of their uppercase counterpart, as in the encode table
+    MorseCode found = MORSE_CODE_NONE;
+    uint8_t found_length = MORSE_CODE_MAX_LENGTH + 1;
+    CODE_FIND(root, (unsigned char)toupper((unsigned char)alnum_character), &found, &found_length);
+    if (found == MORSE_CODE_NONE) { return 0; }
+
+    char code[MORSE_CODE_MAX_LENGTH];
+    size_t len = write_code(code, found);
+    copy_truncated(output, capacity, 0, code, len);
+    if (capacity > 0) output[len < capacity ? len : capacity - 1] = '\0';
+    MORSE_STATS_CALL(encode_calls, 1, len < capacity ? len : (capacity > 0 ? capacity - 1 : 0));
+    return len;
+}
+
+char* encode_letter(const BTreeNode* root, const char alnum_character)
+{
+    char code[MORSE_CODE_MAX_LENGTH + 1];
+    size_t len = encode_letter_into(root, alnum_character, code, sizeof(code));
+    if (len == 0) { return NULL; }
+
+    char* result = malloc(len + 1);
+    MORSE_STATS_MALLOC(result, len + 1);
+    if (!result) { return NULL; }
+    MEMORY_COPY(result, code, len + 1);
+    return result;
+}
+
+// Reverse `string` into `output`, returns its length; at most capacity - 1 bytes
+// and a terminator are written
+size_t reverse_string_into(const char* string, char* output, size_t capacity)
+{
+    size_t len = strlen(string);
+    if (capacity == 0) { return len; }
+    size_t fits = len < capacity ? len : capacity - 1;
+    for (size_t i = 0; i < fits; i++) { output[i] = string[len - 1 - i]; }
+    output[fits] = '\0';
+    return len;
 }
 
 char* reverse_string(const char* string)
 {
     size_t len = strlen(string);
     char* reversed = malloc(len + 1);
+    MORSE_STATS_MALLOC(reversed, len + 1);
     if (!reversed) { return NULL; }
-    for (size_t i = 0; i < len; i++) { reversed[i] = string[len - 1 - i]; }
-    reversed[len] = '\0';
+    reverse_string_into(string, reversed, len + 1);
     return reversed;
 }
 
-// Morse Code to Alphabet
-char* morse_decode(BTreeNode* root, const char* morse_message)
+// Morse Code to Alphabet, reference implementation walking the tree per letter
+char* morse_decode_reference(const BTreeNode* root, const char* morse_message)
 {
     if (!root || !morse_message) { return NULL; }
     size_t cap = 256;
     size_t len = 0;
     char* output = malloc(cap);
+    MORSE_STATS_MALLOC(output, cap);
     if (!output)
     {
         fprintf(stderr, "Memory allocation failed\n"); 
@@ -312,7 +477,8 @@ char* morse_decode(BTreeNode* root, const char* morse_message)
             if (len + 1 >= cap) {
                 cap *= 2;
                 char* tmp = realloc(output, cap);
-                if (!tmp) { free(output); return NULL; }
+                MORSE_STATS_REALLOC(tmp, cap);
+                if (!tmp) { MORSE_STATS_FREE(output); free(output); return NULL; }
                 output = tmp;
             }
             output[len++] = ' ';
@@ -329,20 +495,15 @@ char* morse_decode(BTreeNode* root, const char* morse_message)
             while (segment_ptr < segment_trim_end && *segment_ptr != ' ') segment_ptr++;
 
             size_t token_len = (size_t)(segment_ptr - word_ptr);
-            char* token = malloc(token_len + 1);
-            if (!token) { free(output); return NULL; }
-            MEMORY_COPY(token, word_ptr, token_len);
-            token[token_len] = '\0';
-
-            char decoded = decode_letter(root, token);
-            free(token);
+            char decoded = decode_letter_n(root, word_ptr, token_len);
 
             if (decoded == '\0') decoded = '?'; /* avoid embedding NUL in output */
 
             if (len + 1 >= cap) {
                 cap *= 2;
                 char *tmp = realloc(output, cap);
-                if (!tmp) { free(output); return NULL; }
+                MORSE_STATS_REALLOC(tmp, cap);
+                if (!tmp) { MORSE_STATS_FREE(output); free(output); return NULL; }
                 output = tmp;
             }
             output[len++] = decoded;
@@ -352,73 +513,568 @@ char* morse_decode(BTreeNode* root, const char* morse_message)
         ptr = segment_end;
         if (*ptr == '/') ptr++;
     }
-    if (len > 0 && output[len - 1] == ' ') output[len - 1] = '\0';
+    if (len > 0 && output[len - 1] == ' ') output[--len] = '\0';
+    MORSE_STATS_CALL(decode_calls, (size_t)(ptr - morse_message), len);
     return output;
 }
 
-// Alphabet to Morse Code
-char* morse_encode(BTreeNode* root, const char* text_message)
+static inline char decode_symbols(const MorseDecodeTable* table, unsigned bits, size_t symbols)
 {
-    if (!root || !text_message) { return NULL; }
+    if (symbols > MORSE_CODE_MAX_LENGTH) return '?';
+    char decoded = table->alnum_character[MORSE_CODE_PACK(bits, symbols)];
+    return decoded != '\0' ? decoded : '?'; /* avoid embedding NUL in output */
+}
+
+// Morse Code to Alphabet
+char* morse_decode(const BTreeNode* root, const char* morse_message)
+{
+    if (!root || !morse_message) { return NULL; }
+
+    MorseDecodeTable table;
+    morse_decode_table_build(root, &table);
+    return morse_decode_with_table(&table, morse_message);
+}
+
+static inline void token_append(MorseToken* token, bool is_dash)
+{
+    if (is_dash && token->symbols < MORSE_CODE_MAX_LENGTH) { token->bits |= 1u << token->symbols; }
+    token->symbols++;
+}
+
+static inline char token_decode(const MorseDecodeTable* table, const MorseToken* token)
+{
+    return token->poisoned ? '?' : decode_symbols(table, token->bits, token->symbols);
+}
+
+// Decode the first n bytes of a classified block, returns the number of bytes written.
+// Every '/' writes a word space; letters containing a byte flagged in `poison` decode to '?'.
+static size_t decode_block(const MorseDecodeTable* table, const MorseBlockMasks* masks, size_t n,
+                           uint64_t poison, MorseToken* token, char* output)
+{
+    const uint64_t valid = n == MORSE_SCAN_BLOCK ? ~(uint64_t)0 : ((uint64_t)1 << n) - 1;
+    const uint64_t separators = (masks->space | masks->slash) & valid;
+    const uint64_t symbols = masks->dot | masks->dash;
 
-    size_t cap = 256;
     size_t len = 0;
-    char* output = malloc(cap);
-    if (!output)
+    size_t pos = 0;
+    while (pos < n)
     {
-        fprintf(stderr, "Memory allocation failed\n"); 
-        return NULL;
+        uint64_t separators_ahead = separators >> pos;
+        if (!(separators_ahead & 1u))
+        {
+            // Token bytes up to the next separator
+            size_t run = separators_ahead ? MORSE_CTZ64(separators_ahead) : n - pos;
+            uint64_t run_mask = run == MORSE_SCAN_BLOCK ? ~(uint64_t)0 : ((uint64_t)1 << run) - 1;
+            uint64_t run_symbols = (symbols >> pos) & run_mask;
+            uint64_t run_dashes = (masks->dash >> pos) & run_mask;
+
+            if (run_symbols == run_mask && token->symbols + run <= MORSE_CODE_MAX_LENGTH)
+            {
+                token->bits |= (unsigned)run_dashes << token->symbols;
+                token->symbols += run;
+            } else
+            {
+                // Bytes other than '.'/'-' are skipped, like the tree walk does
+                for (; run_symbols; run_symbols &= run_symbols - 1)
+                {
+                    token_append(token, (run_dashes >> MORSE_CTZ64(run_symbols)) & 1u);
+                }
+            }
+            if ((poison >> pos) & run_mask) { token->poisoned = true; }
+            token->in_token = true;
+            pos += run;
+            continue;
+        }
+
+        if (token->in_token)
+        {
+            output[len++] = token_decode(table, token);
+            *token = (MorseToken){ 0, 0, false, false };
+        }
+
+        // Separator run: spaces only split letters, every '/' splits words
+        uint64_t tokens_ahead = (~separators & valid) >> pos;
+        size_t run = tokens_ahead ? MORSE_CTZ64(tokens_ahead) : n - pos;
+        uint64_t run_mask = run == MORSE_SCAN_BLOCK ? ~(uint64_t)0 : ((uint64_t)1 << run) - 1;
+        size_t slashes = MORSE_POPCOUNT64((masks->slash >> pos) & run_mask);
+        memset(output + len, ' ', slashes);
+        len += slashes;
+        pos += run;
     }
-    output[0] = '\0';
+    return len;
+}
 
-    for (size_t i = 0; i < strlen(text_message); i++)
+// Decode a span a byte at a time, for callers that decode a message in pieces: one letter
+// per token, one space per '/', nothing trimmed and no call counted. Invalid bytes are
+// treated as `mode` says and the first is reported in `invalid_offset`; strict decoding
+// stops there. Returns the bytes written, at most `length`.
+size_t morse_decode_chars(const MorseDecodeTable* table, const char* morse_message, size_t length,
+                          MorseDecodeMode mode, char* output, size_t* invalid_offset)
+{
+    *invalid_offset = MORSE_DECODE_NO_ERROR;
+    MorseToken token = { 0, 0, false, false };
+    size_t len = 0;
+    for (size_t i = 0; i < length; i++)
     {
-        char ch = text_message[i];
-        if (ch == ' ')
+        char ch = morse_message[i];
+        if (ch == ' ' || ch == '/')
         {
-            if (len + 2 >= cap) {
-                while (len + 2 >= cap) cap *= 2;
-                char *tmp = realloc(output, cap);
-                if (!tmp) { free(output); return NULL; }
-                output = tmp;
-            }
-            output[len++] = '/';
-            output[len++] = ' ';
-            output[len] = '\0';
+            if (token.in_token) output[len++] = token_decode(table, &token);
+            token = (MorseToken){ 0, 0, false, false };
+            if (ch == '/') output[len++] = ' ';
             continue;
         }
-        if (!isalnum(ch)) { continue; } // ignore non-alphabetic characters; you could append '?' instead
 
-        char uppercase_ch = toupper(ch);
-        char* morse_code = encode_letter(root, uppercase_ch);
-        if (!morse_code) {
-            if (len + 1 >= cap) {
-                cap *= 2;
-                char* tmp = realloc(output, cap);
-                if (!tmp) { free(output); return NULL; }
-                output = tmp;
-            }
-            output[len++] = '?';
-            output[len] = '\0';
+        token.in_token = true;
+        if (ch == '.' || ch == '-')
+        {
+            token_append(&token, ch == '-');
             continue;
         }
+        if (*invalid_offset == MORSE_DECODE_NO_ERROR) *invalid_offset = i;
+        if (mode == MORSE_DECODE_STRICT) return len;
+        if (mode == MORSE_DECODE_LENIENT) token.poisoned = true;
+    }
+    if (token.in_token) output[len++] = token_decode(table, &token);
+    return len;
+}
+
+void morse_decoder_init(MorseDecoder* decoder, const BTreeNode* root, MorseDecodeMode mode)
+{
+    MorseDecodeTable table;
+    morse_decode_table_build(root, &table);
+    morse_decoder_init_with_table(decoder, &table, mode);
+}
+
+void morse_decoder_init_with_table(MorseDecoder* decoder, const MorseDecodeTable* table, MorseDecodeMode mode)
+{
+    MORSE_STATS_ADD(decode_calls, 1);
+    decoder->table = *table;
+    decoder->mode = mode;
+    decoder->classify = morse_classify_select();
+    decoder->token = (MorseToken){ 0, 0, false, false };
+    decoder->last_was_slash = false;
+    decoder->held_spaces = 0;
+    decoder->consumed = 0;
+    decoder->error_offset = MORSE_DECODE_NO_ERROR;
+}
+
+// Classifies the chunk a block at a time and packs each token into a MorseCode in the
+// same pass, then reads the letter from the table. Letters may span chunks.
+// `output` must hold MORSE_DECODER_FEED_BOUND(length) bytes; returns false when a
+// strict decoder meets an invalid byte (see decoder->error_offset).
+bool morse_decoder_feed(MorseDecoder* decoder, const char* input, size_t length, char* output, size_t* written)
+{
+    *written = 0;
+    if (length == 0) return true;
+
+    size_t len = decoder->held_spaces;
+    memset(output, ' ', len);
+    decoder->held_spaces = 0;
+
+    for (size_t offset = 0; offset < length; offset += MORSE_SCAN_BLOCK)
+    {
+        size_t n = length - offset;
+        const char* block = input + offset;
+        char padded[MORSE_SCAN_BLOCK];
+        if (n < MORSE_SCAN_BLOCK)
+        {
+            MEMORY_COPY(padded, block, n);
+            memset(padded + n, '\0', MORSE_SCAN_BLOCK - n);
+            block = padded;
+        } else
+        {
+            n = MORSE_SCAN_BLOCK;
+        }
+
+        MorseBlockMasks masks;
+        decoder->classify(block, &masks);
+
+        uint64_t valid = n == MORSE_SCAN_BLOCK ? ~(uint64_t)0 : ((uint64_t)1 << n) - 1;
+        uint64_t invalid = valid & ~(masks.dot | masks.dash | masks.space | masks.slash);
+        if (invalid && decoder->error_offset == MORSE_DECODE_NO_ERROR)
+        {
+            decoder->error_offset = decoder->consumed + offset + MORSE_CTZ64(invalid);
+            if (decoder->mode == MORSE_DECODE_STRICT)
+            {
+                *written = len;
+                return false;
+            }
+        }
 
-        size_t morse_code_len = strlen(morse_code);
-        if (len + morse_code_len + 1 >= cap) { // +1 for trailing space or terminator
-            while (len + morse_code_len + 1 >= cap) cap *= 2;
-            char *tmp = realloc(output, cap);
-            if (!tmp) { free(morse_code); free(output); return NULL; }
-            output = tmp;
+        uint64_t poison = decoder->mode == MORSE_DECODE_LENIENT ? invalid : 0;
+        len += decode_block(&decoder->table, &masks, n, poison, &decoder->token, output + len);
+    }
+    decoder->consumed += length;
+    decoder->last_was_slash = input[length - 1] == '/';
+    MORSE_STATS_ADD(bytes_in, length);
+
+    // Withhold trailing spaces: a final '/' writes no space and one trailing space is trimmed
+    while (decoder->held_spaces < 2 && len > 0 && output[len - 1] == ' ')
+    {
+        len--;
+        decoder->held_spaces++;
+    }
+    *written = len;
+    MORSE_STATS_ADD(bytes_out, len);
+    return true;
+}
+
+// Flush the last letter, `output` must hold MORSE_DECODER_FINISH_BOUND bytes
+size_t morse_decoder_finish(MorseDecoder* decoder, char* output)
+{
+    size_t len = 0;
+    if (decoder->token.in_token)
+    {
+        memset(output, ' ', decoder->held_spaces);
+        len = decoder->held_spaces;
+        output[len++] = token_decode(&decoder->table, &decoder->token);
+    } else
+    {
+        size_t held = decoder->held_spaces;
+        if (decoder->last_was_slash && held > 0) held--;
+        if (held > 0) held--;
+        memset(output, ' ', held);
+        len = held;
+    }
+    decoder->token = (MorseToken){ 0, 0, false, false };
+    decoder->held_spaces = 0;
+    MORSE_STATS_ADD(bytes_out, len);
+    return len;
+}
+
+char* morse_decode_with_table(const MorseDecodeTable* table, const char* morse_message)
+{
+    if (!table || !morse_message) { return NULL; }
+    return morse_decode_checked_with_table(table, morse_message, strlen(morse_message), MORSE_DECODE_SKIP, NULL);
+}
+
+// Exact length of the decoded message, without decoding it: one letter per token,
+// one space per '/', minus the trailing spaces the end-of-message rules trim
+size_t morse_decode_size(const char* morse_message, size_t message_len)
+{
+    if (!morse_message) { return 0; }
+
+    size_t letters = 0;
+    size_t slashes = 0;
+    size_t trailing_slashes = 0; // since the last token
+    bool in_token = false;
+    for (size_t i = 0; i < message_len; i++)
+    {
+        char ch = morse_message[i];
+        bool separator = ch == ' ' || ch == '/';
+        if (!separator && !in_token)
+        {
+            letters++;
+            trailing_slashes = 0;
         }
+        if (ch == '/')
+        {
+            slashes++;
+            trailing_slashes++;
+        }
+        in_token = !separator;
+    }
+
+    size_t trimmed = message_len > 0 && morse_message[message_len - 1] == '/' ? 2 : 1;
+    if (trimmed > trailing_slashes) trimmed = trailing_slashes;
+    return letters + slashes - trimmed;
+}
+
+size_t morse_decode_into(const BTreeNode* root, const char* morse_message, size_t message_len,
+                         char* output, size_t capacity)
+{
+    if (capacity > 0) output[0] = '\0';
+    if (!root || !morse_message) { return 0; }
+
+    MorseDecodeTable table;
+    morse_decode_table_build(root, &table);
+    return morse_decode_into_with_table(&table, morse_message, message_len, output, capacity);
+}
+
+// Decode into a caller buffer, returns the decoded length; at most capacity - 1 bytes
+// and a terminator are written. Size the buffer with morse_decode_size() + 1.
+size_t morse_decode_into_with_table(const MorseDecodeTable* table, const char* morse_message, size_t message_len,
+                                    char* output, size_t capacity)
+{
+    if (capacity > 0) output[0] = '\0';
+    if (!table || !morse_message) { return 0; }
+
+    MorseDecoder decoder;
+    morse_decoder_init_with_table(&decoder, table, MORSE_DECODE_SKIP);
 
-        MEMORY_COPY(output + len, morse_code, morse_code_len);
-        len += morse_code_len;
-        output[len++] = ' ';  // space between letters
+    // Every output byte consumes at least one input byte, so a buffer one byte longer
+    // than the message takes the decoder's output directly
+    if (capacity > message_len)
+    {
+        size_t len = 0;
+        morse_decoder_feed(&decoder, morse_message, message_len, output, &len);
+        len += morse_decoder_finish(&decoder, output + len);
         output[len] = '\0';
+        return len;
+    }
 
-        free(morse_code);
+    // Otherwise decode in pieces through a local buffer and keep what fits
+    enum { PIECE = 256 };
+    char piece[MORSE_DECODER_FEED_BOUND(PIECE) + MORSE_DECODER_FINISH_BOUND];
+    size_t total = 0;
+    for (size_t offset = 0; offset < message_len; offset += PIECE)
+    {
+        size_t n = message_len - offset < PIECE ? message_len - offset : PIECE;
+        size_t written = 0;
+        morse_decoder_feed(&decoder, morse_message + offset, n, piece, &written);
+        copy_truncated(output, capacity, total, piece, written);
+        total += written;
+    }
+    size_t written = morse_decoder_finish(&decoder, piece);
+    copy_truncated(output, capacity, total, piece, written);
+    total += written;
+
+    if (capacity > 0) output[total < capacity ? total : capacity - 1] = '\0';
+    return total;
+}
+
+// Validate and decode in one pass over a length-delimited message
+char* morse_decode_checked(const BTreeNode* root, const char* morse_message, size_t message_len,
+                           MorseDecodeMode mode, size_t* error_offset)
+{
+    if (error_offset) *error_offset = MORSE_DECODE_NO_ERROR;
+    if (!root || !morse_message) { return NULL; }
+
+    MorseDecodeTable table;
+    morse_decode_table_build(root, &table);
+    return morse_decode_checked_with_table(&table, morse_message, message_len, mode, error_offset);
+}
+
+char* morse_decode_checked_with_table(const MorseDecodeTable* table, const char* morse_message, size_t message_len,
+                                      MorseDecodeMode mode, size_t* error_offset)
+{
+    if (error_offset) *error_offset = MORSE_DECODE_NO_ERROR;
+    if (!table || !morse_message) { return NULL; }
+
+    char* output = malloc(message_len + 1); // every output byte consumes at least one input byte
+    MORSE_STATS_MALLOC(output, message_len + 1);
+    if (!output)
+    {
+        fprintf(stderr, "Memory allocation failed\n");
+        return NULL;
+    }
+
+    MorseDecoder decoder;
+    morse_decoder_init_with_table(&decoder, table, mode);
+    size_t len = 0;
+    bool decoded = morse_decoder_feed(&decoder, morse_message, message_len, output, &len);
+    if (error_offset) *error_offset = decoder.error_offset;
+    if (!decoded)
+    {
+        MORSE_STATS_FREE(output);
+        free(output);
+        return NULL;
+    }
+    len += morse_decoder_finish(&decoder, output + len);
+    output[len] = '\0';
+    return output;
+}
+
+// Alphabet to Morse Code
+char* morse_encode(const BTreeNode* root, const char* text_message)
+{
+    if (!root || !text_message) { return NULL; }
+
+    MorseEncodeTable table;
+    morse_encode_table_build(root, &table);
+    return morse_encode_with_table(&table, text_message);
+}
+
+static char* encode_buffer(const MorseEncodeTable* table, const char* text_message, size_t length);
+
+static inline size_t encode_char(const MorseEncodeTable* table, unsigned char ch, char* output)
+{
+    if (ch == ' ')
+    {
+        output[0] = '/';
+        output[1] = ' ';
+        return 2;
+    }
+    if (!isalnum(ch)) { return 0; } // ignore non-alphabetic characters; you could append '?' instead
+    if (table->code[ch] == MORSE_CODE_NONE)
+    {
+        output[0] = '?';
+        return 1;
+    }
+    size_t len = write_code(output, table->code[ch]);
+    output[len++] = ' ';  // space between letters
+    return len;
+}
+
+char* morse_encode_with_table(const MorseEncodeTable* table, const char* text_message)
+{
+    if (!table || !text_message) { return NULL; }
+    return encode_buffer(table, text_message, strlen(text_message));
+}
+
+// Alphabet to Morse Code for a length-delimited message
+char* morse_encode_n(const BTreeNode* root, const char* text_message, size_t length)
+{
+    if (!root || !text_message) { return NULL; }
+
+    MorseEncodeTable table;
+    morse_encode_table_build(root, &table);
+    return encode_buffer(&table, text_message, length);
+}
+
+char* morse_encode_n_with_table(const MorseEncodeTable* table, const char* text_message, size_t length)
+{
+    if (!table || !text_message) { return NULL; }
+    return encode_buffer(table, text_message, length);
+}
+
+// Exact encoded size of a message, before the trailing space is trimmed
+size_t morse_encoded_length(const MorseEncodeTable* table, const char* text_message, size_t length)
+{
+    size_t total = 0;
+    for (size_t i = 0; i < length; i++) { total += table->width[(unsigned char)text_message[i]]; }
+    return total;
+}
+
+// Encode into a buffer already sized with morse_encoded_length, returns the bytes written
+size_t morse_encode_span(const MorseEncodeTable* table, const char* text_message, size_t length, char* output)
+{
+    size_t len = morse_encode_chars(table, text_message, length, output);
+    MORSE_STATS_CALL(encode_calls, length, len);
+    return len;
+}
+
+// morse_encode_span without counting a call, for callers that encode a message in pieces
+size_t morse_encode_chars(const MorseEncodeTable* table, const char* text_message, size_t length, char* output)
+{
+    size_t len = 0;
+    for (size_t i = 0; i < length; i++) { len += encode_char(table, (unsigned char)text_message[i], output + len); }
+    return len;
+}
+
+// Exact length of the encoded message, the trailing space already trimmed
+size_t morse_encode_size(const BTreeNode* root, const char* text_message, size_t length)
+{
+    if (!root || !text_message) { return 0; }
+
+    MorseEncodeTable table;
+    morse_encode_table_build(root, &table);
+    return morse_encode_size_with_table(&table, text_message, length);
+}
+
+size_t morse_encode_size_with_table(const MorseEncodeTable* table, const char* text_message, size_t length)
+{
+    if (!table || !text_message) { return 0; }
+
+    // Output ends in a space unless the last character that writes anything writes '?'
+    size_t last = length;
+    while (last > 0 && table->width[(unsigned char)text_message[last - 1]] == 0) last--;
+    size_t total = morse_encoded_length(table, text_message, length);
+    if (last > 0 && table->width[(unsigned char)text_message[last - 1]] > 1) total--;
+    return total;
+}
+
+size_t morse_encode_into(const BTreeNode* root, const char* text_message, size_t length, char* output, size_t capacity)
+{
+    if (capacity > 0) output[0] = '\0';
+    if (!root || !text_message) { return 0; }
+
+    MorseEncodeTable table;
+    morse_encode_table_build(root, &table);
+    return morse_encode_into_with_table(&table, text_message, length, output, capacity);
+}
+
+// Encode into a caller buffer, returns the encoded length; at most capacity - 1 bytes
+// and a terminator are written. Size the buffer with morse_encode_size() + 1.
+size_t morse_encode_into_with_table(const MorseEncodeTable* table, const char* text_message, size_t length,
+                                    char* output, size_t capacity)
+{
+    if (capacity > 0) output[0] = '\0';
+    if (!table || !text_message) { return 0; }
+
+    size_t len = 0;
+    bool ends_in_space = false;
+    for (size_t i = 0; i < length; i++)
+    {
+        unsigned char ch = (unsigned char)text_message[i];
+        size_t written;
+        if (len + MORSE_CODE_MAX_LENGTH + 1 < capacity)
+        {
+            written = encode_char(table, ch, output + len);
+        } else
+        {
+            // Near the end of the buffer: encode aside and keep what fits
+            char code[MORSE_CODE_MAX_LENGTH + 1];
+            written = encode_char(table, ch, code);
+            copy_truncated(output, capacity, len, code, written);
+        }
+        if (written > 0) ends_in_space = written > 1; // only '?' is written without a space
+        len += written;
     }
     // Remove trailing space if exists
-    if (len > 0 && output[len - 1] == ' ') output[len - 1] = '\0';
+    if (ends_in_space) len--;
+
+    if (capacity > 0) output[len < capacity ? len : capacity - 1] = '\0';
+    MORSE_STATS_CALL(encode_calls, length, len < capacity ? len : (capacity > 0 ? capacity - 1 : 0));
+    return len;
+}
+
+static char* encode_buffer(const MorseEncodeTable* table, const char* text_message, size_t length)
+{
+    // One sizing pass, so the output is allocated exactly once
+    size_t size = morse_encode_size_with_table(table, text_message, length);
+    char* output = malloc(size + 1);
+    MORSE_STATS_MALLOC(output, size + 1);
+    if (!output)
+    {
+        fprintf(stderr, "Memory allocation failed\n"); 
+        return NULL;
+    }
+    morse_encode_into_with_table(table, text_message, length, output, size + 1);
     return output;
 }
+
+void morse_encoder_init(MorseEncoder* encoder, const BTreeNode* root)
+{
+    MORSE_STATS_ADD(encode_calls, 1);
+    morse_encode_table_build(root, &encoder->table);
+    encoder->held_space = false;
+}
+
+void morse_encoder_init_with_table(MorseEncoder* encoder, const MorseEncodeTable* table)
+{
+    MORSE_STATS_ADD(encode_calls, 1);
+    encoder->table = *table;
+    encoder->held_space = false;
+}
+
+// Encode one chunk, `output` must hold MORSE_ENCODER_FEED_BOUND(length) bytes
+size_t morse_encoder_feed(MorseEncoder* encoder, const char* input, size_t length, char* output)
+{
+    if (length == 0) return 0;
+
+    size_t len = 0;
+    if (encoder->held_space) output[len++] = ' ';
+    for (size_t i = 0; i < length; i++)
+    {
+        len += encode_char(&encoder->table, (unsigned char)input[i], output + len);
+    }
+    // The message may end here, in which case its trailing space is dropped
+    encoder->held_space = len > 0 && output[len - 1] == ' ';
+    if (encoder->held_space) len--;
+    MORSE_STATS_ADD(bytes_in, length);
+    MORSE_STATS_ADD(bytes_out, len);
+    return len;
+}
+
+void morse_encoder_finish(MorseEncoder* encoder)
+{
+    encoder->held_space = false;
+}
+
+void morse_free(void* ptr)
+{
+    MORSE_STATS_FREE(ptr);
+    free(ptr);
+}
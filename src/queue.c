@@ -1,6 +1,6 @@
+#include "arena.h"
 #include "morse.h"
 #include <stdbool.h>
-#include <stdlib.h>
 
 
 bool valid_QueueNode (Node qn)
@@ -9,4 +9,4 @@ bool valid_QueueNode (Node qn)
     return true;
 }
 
-GENERATE_QUEUE(Node, size_t, NODE_QUEUE_INIT_SIZE, NODE_QUEUE_GROWTH_FACTOR, valid_QueueNode, malloc, realloc, free)
+GENERATE_QUEUE_WITH_ALLOCATOR(Node, size_t, NODE_QUEUE_INIT_SIZE, NODE_QUEUE_GROWTH_FACTOR, valid_QueueNode)
@@ -1,6 +1,6 @@
+#include "arena.h"
 #include "morse.h"
 #include <stdbool.h>
-#include <stdlib.h>
 
 
 bool valid_StackNode (Node sn)
@@ -9,4 +9,4 @@ bool valid_StackNode (Node sn)
     return true;
 }
 
-GENERATE_STACK(Node, size_t, NODE_STACK_INIT_SIZE, NODE_STACK_GROWTH_FACTOR, valid_StackNode, malloc, realloc, free)
+GENERATE_STACK_WITH_ALLOCATOR(Node, size_t, NODE_STACK_INIT_SIZE, NODE_STACK_GROWTH_FACTOR, valid_StackNode)
@@ -0,0 +1,144 @@
+#include "morse.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+
+/**
+ * Morse table generator
+ * ---------------------
+ * Builds the default alphabet with the library's own tree and table code
+ * and prints the results as static const C data, so the translator does
+ * no table work at startup. Run by the makefile:
+ *
+ *   build/morse-tables-gen > build/gen/morse-tables-data.h
+ */
+
+static const char* MORSE_CODE_SEQUENCE[] = {
+    ".-", "-...", "-.-.", "-..", ".", "..-.", "--.", "....", "..",
+    ".---", "-.-", ".-..", "--", "-.", "---", ".--.", "--.-", ".-.",
+    "...", "-", "..-", "...-", ".--", "-..-", "-.--", "--..", "-----",
+    ".----", "..---", "...--", "....-", ".....", "-....", "--...", "---..", "----."
+};
+
+static const char ALPHABET[] = {
+    'A','B','C','D','E','F','G','H','I','J','K','L','M',
+    'N','O','P','Q','R','S','T','U','V','W','X','Y','Z',
+    '0','1','2','3','4','5','6','7','8','9'
+};
+
+static const size_t ALPHABET_SIZE = sizeof(ALPHABET) / sizeof(ALPHABET[0]);
+
+// Implicit heap layout shared by the flat backend and the generated pointer tree
+#define TREE_SIZE ((1u << (MORSE_CODE_MAX_LENGTH + 1)) - 1)
+#define TREE_CHILD(index, is_dash) (2 * (index) + 1 + (is_dash))
+
+
+static void print_bytes(const char* name, const uint8_t* bytes, size_t count)
+{
+    printf("    .%s = {", name);
+    for (size_t i = 0; i < count; i++)
+    {
+        printf(i % 16 == 0 ? "\n        " : " ");
+        printf("%u,", (unsigned)bytes[i]);
+    }
+    printf("\n    },\n");
+}
+
+static void print_character(char ch)
+{
+    if (ch == '\0') printf("0");
+    else printf("'%c'", ch);
+}
+
+int main(void)
+{
+    BTreeNode* root = morse_tree_init();
+    if (!root)
+    {
+        fprintf(stderr, "Memory error\n");
+        return 1;
+    }
+    for (size_t i = 0; i < ALPHABET_SIZE; i++)
+    {
+        morse_tree_insert(root, MORSE_CODE_SEQUENCE[i], ALPHABET[i]);
+    }
+
+    MorseEncodeTable encode;
+    MorseDecodeTable decode;
+    morse_encode_table_build(root, &encode);
+    morse_decode_table_build(root, &decode);
+    morse_tree_delete(root);
+
+    // Place every decodable code at its heap index
+    char tree[TREE_SIZE] = { 0 };
+    for (unsigned code = 1; code < 256; code++)
+    {
+        if (decode.alnum_character[code] == '\0') continue;
+        size_t index = 0;
+        for (unsigned rest = code; rest > 1; rest >>= 1) { index = TREE_CHILD(index, rest & 1u); }
+        tree[index] = decode.alnum_character[code];
+    }
+
+    // A pointer tree node exists where a character lives at or below it
+    bool present[TREE_SIZE] = { false };
+    size_t slot[TREE_SIZE] = { 0 };
+    for (size_t i = TREE_SIZE; i-- > 0;)
+    {
+        bool children = TREE_CHILD(i, 1) < TREE_SIZE && (present[TREE_CHILD(i, 0)] || present[TREE_CHILD(i, 1)]);
+        present[i] = i == 0 || tree[i] != '\0' || children;
+    }
+    size_t nodes = 0;
+    for (size_t i = 0; i < TREE_SIZE; i++)
+    {
+        if (present[i]) slot[i] = nodes++;
+    }
+
+    printf("/* Generated by tools/morse-tables-gen.c, do not edit */\n\n");
+
+    printf("const MorseEncodeTable MORSE_ENCODE_TABLE_DEFAULT = {\n");
+    print_bytes("code", encode.code, 256);
+    print_bytes("length", encode.length, 256);
+    print_bytes("width", encode.width, 256);
+    printf("};\n\n");
+
+    printf("const MorseDecodeTable MORSE_DECODE_TABLE_DEFAULT = {\n");
+    print_bytes("alnum_character", (const uint8_t*)decode.alnum_character, 256);
+    printf("};\n\n");
+
+    printf("#ifdef MORSE_TREE_FLAT\n");
+    printf("static const BTreeNode MORSE_TREE_DEFAULT_ROOT = {\n    .alnum_character = {");
+    for (size_t i = 0; i < TREE_SIZE; i++)
+    {
+        printf(i % 16 == 0 ? "\n        " : " ");
+        print_character(tree[i]);
+        printf(",");
+    }
+    printf("\n    },\n};\n");
+    printf("#define MORSE_TREE_DEFAULT (&MORSE_TREE_DEFAULT_ROOT)\n");
+
+    printf("#else\n");
+    printf("static const BTreeNode MORSE_TREE_DEFAULT_NODES[%zu] = {\n", nodes);
+    for (size_t i = 0; i < TREE_SIZE; i++)
+    {
+        if (!present[i]) continue;
+        printf("    { ");
+        print_character(tree[i]);
+        for (int dash = 0; dash < 2; dash++)
+        {
+            size_t child = TREE_CHILD(i, (size_t)dash);
+            if (child < TREE_SIZE && present[child])
+            {
+                printf(", (BTreeNode*)&MORSE_TREE_DEFAULT_NODES[%zu]", slot[child]);
+            } else
+            {
+                printf(", NULL");
+            }
+        }
+        printf(" },\n");
+    }
+    printf("};\n");
+    printf("#define MORSE_TREE_DEFAULT (&MORSE_TREE_DEFAULT_NODES[0])\n");
+    printf("#endif // MORSE_TREE_FLAT\n");
+
+    return ferror(stdout) ? 1 : 0;
+}